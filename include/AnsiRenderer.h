@@ -0,0 +1,31 @@
+#ifndef ANSI_RENDERER_H
+#define ANSI_RENDERER_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <curses.h>
+
+// writes frames straight to the tty instead of through doupdate: curses windows are still
+// the drawing surface, their cells are copied into a back buffer and only cells that differ
+// from the front buffer are sent, as runs sharing one cursor move and one SGR sequence
+class AnsiRenderer {
+public:
+    AnsiRenderer() = delete;
+
+    static void stage(WINDOW* win);
+    static size_t flush(bool synchronized); // returns the bytes written
+    static void invalidate(); // the terminal was cleared behind our back, repaint everything
+
+private:
+    static std::vector<chtype> front; // what the terminal shows
+    static std::vector<chtype> back;  // what the next frame should show
+    static int rows, cols;
+    static bool repaint;
+    static std::string out;
+
+    static void resize();
+    static void appendAttributes(chtype attributes);
+};
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef BATTLE_ROYALE_H
+#define BATTLE_ROYALE_H
+
+#include <csignal>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Settings.h"
+#include "ThreadPool.h"
+
+// dozens of bot engines in one process; per-player state is stored as parallel arrays
+// so each batch of players steps over contiguous memory
+class BattleRoyale {
+public:
+    enum class Targeting { RANDOM, ATTACKERS };
+
+    struct Config {
+        int players = 32;
+        Targeting targeting = Targeting::RANDOM;
+        int threads = 0; // 0 = one per hardware thread
+        unsigned seed = 0; // 0 = random
+    };
+
+    explicit BattleRoyale(const Config& config);
+
+    void reset();
+    void step(); // every alive player places one piece, then attack is routed
+    int aliveCount() const;
+    long long totalPlacements() const { return placements; }
+
+    void runHeadless(double seconds);
+    static void requestStop(); // async-signal-safe, runHeadless returns after the current round
+    void spectate(const Settings& settings, float roundsPerSecond = 3.0f);
+
+    static Targeting parseTargeting(const std::string& name);
+private:
+    static constexpr int QUEUE_SIZE = 14;
+    static constexpr int GARBAGE_CAP = 8;
+
+    Config config;
+    int count;
+    ThreadPool pool;
+    std::mt19937 routeRng;
+    long long placements = 0;
+    int round = 0;
+    static volatile std::sig_atomic_t stopRequested;
+
+    // struct-of-arrays, index i belongs to player i
+    std::vector<uint16_t> rows; // count * Bitboard::HEIGHT
+    std::vector<char> current;
+    std::vector<char> hold;
+    std::vector<char> queue; // count * QUEUE_SIZE ring of upcoming pieces
+    std::vector<uint8_t> queueHead;
+    std::vector<uint8_t> queueSize;
+    std::vector<uint8_t> alive;
+    std::vector<int> pendingGarbage;
+    std::vector<int> outgoing;
+    std::vector<int> target;
+    std::vector<int> combo;
+    std::vector<int> b2b;
+    std::vector<int> pieces;
+    std::vector<int> linesSent;
+    std::vector<int> linesCleared;
+    std::vector<int> clearCounts; // count * 4, singles through tetrises
+    std::vector<int> perfectClears;
+    std::vector<int> maxCombo;
+    std::vector<int> maxB2b;
+    std::vector<int> score;
+    std::vector<int> eliminatedRound;
+    std::vector<std::mt19937> rngs;
+    std::vector<uint32_t> seeds; // each player's piece generator seed, for exported results
+
+    void exportResults(); // one record per player of a finished game
+
+    void stepPlayer(int i);
+    void routeAttacks();
+    int pickTarget(int i);
+    char popPiece(int i);
+    char peekPiece(int i) const;
+    void refillQueue(int i);
+    void renderSpectator(double elapsed, bool paused);
+};
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// compact board representation: one uint16_t per row, bit x set = column x filled
+class Bitboard {
+public:
+    Bitboard() = delete;
+
+    static constexpr int WIDTH = 10;
+    static constexpr int HEIGHT = 40;
+    static constexpr uint16_t FULL_ROW = (1 << WIDTH) - 1;
+
+    using Rows = std::array<uint16_t, HEIGHT>;
+    using PieceMask = std::array<uint16_t, 4>;
+
+    static const PieceMask& getPieceMask(char type, int rotation);
+    static int getRotationCount(char type);
+    static int getSpawnX(char type);
+
+    static Rows fromBoard(const std::vector<std::vector<int>>& board);
+    static bool fits(const uint16_t* rows, char type, int rotation, int x, int y);
+    static int dropDistance(const uint16_t* rows, char type, int rotation, int x, int y);
+    static void place(uint16_t* rows, char type, int rotation, int x, int y);
+
+    // mask overloads for hot loops that already looked the piece up
+    static bool fits(const uint16_t* rows, const PieceMask& mask, int x, int y);
+    static int dropDistance(const uint16_t* rows, const PieceMask& mask, int x, int y);
+    static void place(uint16_t* rows, const PieceMask& mask, int x, int y);
+    static int clearLines(uint16_t* rows);
+    static bool isEmpty(const uint16_t* rows);
+    // pushes the stack up and fills the bottom with garbage; false if blocks were pushed out the top
+    static bool addGarbage(uint16_t* rows, int lines, int hole);
+};
+
+#endif
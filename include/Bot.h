@@ -0,0 +1,26 @@
+#ifndef BOT_H
+#define BOT_H
+
+#include <cstdint>
+
+// one-ply placement search over bitboards, shared by every bot-controlled engine
+class Bot {
+public:
+    Bot() = delete;
+
+    struct Move {
+        bool valid = false;
+        bool useHold = false;
+        int rotation = 0;
+        int x = 0;
+    };
+
+    // hold/next may be 0 when unavailable; with an empty hold, holding brings in next
+    static Move findMove(const uint16_t* rows, char current, char hold, char next);
+    static double evaluate(const uint16_t* rows, int linesCleared);
+
+private:
+    static void searchPiece(const uint16_t* rows, char type, bool useHold, Move& best, double& bestScore);
+};
+
+#endif
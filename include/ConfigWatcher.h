@@ -0,0 +1,34 @@
+#ifndef CONFIG_WATCHER_H
+#define CONFIG_WATCHER_H
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "SettingsStore.h"
+
+// background thread that watches the settings store with inotify and hands every valid
+// version written to it over to the main thread; the handoff is a single atomic pointer
+// exchange, so the frame loop never blocks on the watcher
+class ConfigWatcher {
+public:
+    ConfigWatcher() = delete;
+
+    static void start(const std::string& path);
+    static void stop();
+
+    // main thread; the newest snapshot since the last call, or null
+    static std::unique_ptr<SettingsStore::Data> take();
+    // main thread; drops anything published so far, used before our own saves
+    static void discard() { take(); }
+private:
+    static std::thread watcher;
+    static std::atomic<bool> running;
+    static std::atomic<SettingsStore::Data*> pending;
+    static std::string watchedPath;
+
+    static void watchLoop();
+};
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef FINESSE_H
+#define FINESSE_H
+
+#include <cstdint>
+
+// minimal key counts to reach every final pose from spawn, built once by searching an empty board
+class Finesse {
+public:
+    Finesse() = delete;
+
+    static void init(); // builds the table up front so the first lookup is free
+
+    // fewest inputs (taps, das to wall, rotations) that land the piece with this footprint,
+    // poses that drop into the same cells share a count; -1 if unreachable
+    static int optimalInputs(char type, int rotation, int x);
+
+    // counts the presses in a Game input log (uppercase shifts and rotations, repeats are free)
+    static int countInputs(const char* log, int length);
+    // soft drops are tucks or spins, those placements are not judged
+    static bool isJudgeable(const char* log, int length);
+private:
+    static constexpr int MIN_X = -3;
+    static constexpr int COLUMNS = 13; // x from -3 to 9
+};
+
+#endif
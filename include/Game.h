@@ -7,28 +7,76 @@
 #include <unordered_map>
 #include <chrono>
 #include <queue>
+#include <deque>
 #include <unordered_set>
+#include <array>
+#include <csignal>
+#include <random>
+#include <string>
+#include <curses.h>
 
 #include "Settings.h"
 #include "Tetromino.h"
 #include "GameUtils.h"
+#include "Bitboard.h"
+#include "InputReader.h"
+#include "HoldEstimator.h"
+#include "PracticeHistory.h"
+#include "RollingStats.h"
+#include "Leaderboard.h"
+#include "TripleBuffer.h"
 
 class Game {
 public:
     Game();
+    ~Game();
     void reset();
     void newPiece();
     void init();
+    void start(const Settings& settings);
     void run(const Settings& settings);
+    void step(const Settings& settings, const std::vector<InputEvent>& input);
     void update();
-    void render();
+    void render(); // draws the newest published frame; the render thread's only entry point
+    double waitWhilePaused(const Settings& settings);
     bool canPlace(const Tetromino& piece);
     void placePiece(const Tetromino& piece);
+
+    // versus hooks
+    void setViewport(int x, int width);
+    void setLabel(const std::string& text) { label = text; }
+    void setBotControlled(bool enabled, float piecesPerSecond = 1.0f);
+    void receiveGarbage(int lines);
+    int takeOutgoingAttack();
+    void addPausedTime(double seconds) {
+        totalPausedDuration += seconds;
+        simClock += std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds));
+    }
+    void invalidate();
+
+    bool running() const { return isRunning; }
+    bool paused() const { return isPaused; }
+    bool quit() const { return quitPressed; }
+    bool restartRequested() const { return restartPressed; }
+    double getGameTime() const { return gameTime; }
+
+    // suspend/resume: quitting or losing the terminal mid-game writes the engine state to disk
+    static std::string suspendPath();
+    bool resume(const std::string& path); // also restores the mode; the caller removes the file
+    void endSuspended(); // a resumed game the player declined: recorded, then its results shown
+    static bool requestSuspend(); // async-signal-safe, false when no suspendable game is running
+
+    // simulation rate in ticks per second, independent of how often frames are drawn
+    static void setTickRate(int hz);
+    static int getTickRate();
+    const std::unordered_map<std::string, int>& getStatistics() const { return statistics; }
 private:
     bool isRunning;
     bool quitPressed = false;
+    bool endPressed = false; // quit from the pause screen, the game is scored rather than suspended
     bool isPaused = false;
-    std::atomic<int> lastInput{-1};
+    bool restartPressed = false;
+    bool toppedOut = false;
     std::vector<std::vector<int>> board;
     std::vector<Tetromino> bag;
     Tetromino currentPiece;
@@ -61,27 +109,244 @@ private:
     double gameTime;
     double totalPausedDuration;
 
-    int fallDelay; // ms
-    std::chrono::steady_clock::time_point lastFallTime;
-    std::queue<int> inputQueue;
+    // per-game piece generator; seed plus bags dealt is enough to rebuild its state
+    std::mt19937 rng;
+    uint32_t rngSeed = 0;
+    uint32_t bagsDealt = 0;
+
+    static volatile std::sig_atomic_t suspendable;
+    static volatile std::sig_atomic_t suspendRequested;
+    bool suspend(const std::string& path);
+    bool restore(std::string& blob);
+
+    // fixed timestep: engine time advances in whole ticks behind the wall clock, and every
+    // timer below (gravity, lock delay, das, arr, sdf, garbage) is read against it
+    static std::chrono::steady_clock::duration tickDuration;
+    static constexpr std::chrono::seconds MAX_CATCH_UP{1};
+    std::chrono::steady_clock::time_point simClock;
+    int pendingTicks(); // whole ticks between simClock and now
+    void applyEvent(const Settings& settings, const InputEvent& event);
+    void autoshift(bool releases, bool estimated);
+
+    // gravity in rows per ms; fractions carry over between ticks and several rows can fall in
+    // one, at GameUtils::INSTANT_GRAVITY the piece is kept on the floor after every move
+    double gravity = 1.0 / 500;
+    double fallProgress = 0.0; // rows owed to gravity so far
+    int lockDelayMs = 500;
+    static constexpr int MARATHON_LINES = 150; // marathon and master both end here
+    void applyLevel(); // gravity and lock delay for the mode and level
+    void settle();
+
+    // entry delay after every lock and line-clear delay on top of it after a clear; rotate and
+    // hold pressed meanwhile are buffered and applied as the next piece spawns (IRS/IHS)
+    float areMs = 0.0f;
+    float lineClearMs = 0.0f;
+    bool spawnPending = false;
+    std::chrono::steady_clock::time_point spawnAt;
+    int bufferedRotation = 0; // quarter turns clockwise
+    bool bufferedHold = false;
+    void scheduleSpawn(int lines);
+    void spawnPiece();
+    Tetromino dealPiece(); // next piece off the queue, refilling it from the generator
+
+    // the board as row bitmasks for drop distances, rebuilt on first use after it changes
+    Bitboard::Rows boardRows{};
+    bool boardRowsStale = true;
+    int dropDistance();
     bool leftHeld = false;
     bool rightHeld = false;
     bool softDropHeld = false;
     int lastDirection = 0; // -1 for left, 1 for right, 0 for none
-    std::string popupText;
+    bool leftInitial = true, rightInitial = true;
+    bool leftDCD = false, rightDCD = false;
+    std::chrono::steady_clock::time_point lastLeft;
+    std::chrono::steady_clock::time_point lastRight;
+    // arrival time of the press that started the current shift, so das runs from the real keypress
+    std::chrono::steady_clock::time_point leftPressTime;
+    std::chrono::steady_clock::time_point rightPressTime;
+    bool leftRepeatSeen = false, rightRepeatSeen = false;
+    // legacy terminals send no releases: a key stays held while its repeats keep arriving, and
+    // is let go once none came for a repeat interval and a frame
+    std::chrono::steady_clock::time_point leftSeen, rightSeen, softDropSeen;
+    std::chrono::steady_clock::duration heldWindow{};
+    void expireHeldKeys(bool estimated);
+    bool holdEstimation = false;
+    HoldEstimator holdEstimator;
+    std::vector<InputEvent> estimatedInput;
+    std::chrono::steady_clock::time_point lastSoftDrop;
+    float arr = 0.0f; // auto repeat rate (ms)
+    float das = 0.0f; // delayed auto shift (ms)
+    float dcd = 0.0f; // das cut delay (ms)
+    float sdf = 0.0f; // soft drop factor (ms)
+    uint32_t settingsGeneration = 0; // Settings::generation() the values above were read at
+    std::vector<std::string> popupLines; // split once when shown
+    size_t popupMaxLen = 0;
     std::chrono::steady_clock::time_point popupStartTime;
     float popupDurationSeconds = 0.0;
     std::chrono::steady_clock::time_point gameStart;
 
     std::chrono::steady_clock::time_point lockStartTime;
     bool lockDelayActive = false;
-    const int lockDelayMs = 500; // ms
+
+    // bot control
+    bool botControlled = false;
+    float botPps = 1.0f;
+    std::chrono::steady_clock::time_point pieceSpawnTime;
+
+    // per-piece telemetry
+    int64_t gameId = 0;
+    std::array<char, 24> pieceInputs{};
+    int pieceInputCount = 0;
+    int piecePresses = 0; // key-down inputs finesse counts, not autoshift repeats or soft drop
+    bool pieceSoftDropped = false;
+    RollingStats rolling; // recent pps/apm/vs, fed on every lock
+    void recordResult(); // game history and --results-out, single-player only
+    void finish(); // records the game and shows its results page where the mode has one
+
+    // sprint splits: game time at every Leaderboard::SPLIT_LINES lines, compared on the spot with
+    // the personal best's split for the same line count, copied in when the game starts
+    std::array<double, Leaderboard::MAX_SPLITS> splits{};
+    int splitCount = 0;
+    std::array<double, Leaderboard::MAX_SPLITS> pbSplits{};
+    int pbSplitCount = 0;
+    double pbTime = 0.0; // 0 without a personal best
+    double paceDelta = 0.0; // seconds behind (+) or ahead (-) of the best at the last split
+    bool paceKnown = false;
+    // records a finished sprint, the split and personal best lines for the results page
+    std::vector<std::pair<std::string, std::string>> finishSprint();
+    void exportResult(); // --results-out, finished single-player games
+
+    // practice mode: no gravity, every placement can be undone and redone
+    bool practiceMode = false;
+    PracticeHistory history;
+
+    // garbage exchange
+    struct Garbage {
+        int lines;
+        std::chrono::steady_clock::time_point readyTime;
+    };
+    std::deque<Garbage> incomingGarbage;
+    int outgoingAttack = 0;
+    const int garbageDelayMs = 500; // ms before received garbage can rise
+    const int garbageCap = 8; // max garbage lines inserted per lock
+
+    // rendering: windows persist between frames and only dirty regions are redrawn
+    enum DirtyFlags {
+        DIRTY_BOARD = 1,
+        DIRTY_HOLD = 2,
+        DIRTY_NEXT = 4,
+        DIRTY_STATS = 8,
+        DIRTY_STATIC = 16,
+        DIRTY_POPUP = 32,
+        DIRTY_ALL = 63
+    };
+    static constexpr int REGION_COUNT = 6; // one per dirty flag
+    unsigned dirty = DIRTY_ALL; // engine side, regions changed since the last publish
+
+    // everything render() reads from the engine, copied out after each batch of ticks; the
+    // revisions count changes per region, so frames the renderer skips still mark what changed
+    struct Frame {
+        uint64_t sequence = 0; // 0 until the first publish
+        std::array<uint32_t, REGION_COUNT> revision{};
+        std::vector<std::vector<int>> board;
+        Tetromino current;
+        Tetromino held;
+        std::array<Tetromino, 4> next;
+        int nextCount = 0;
+        std::unordered_map<std::string, int> statistics;
+        double gameTime = 0.0;
+        RollingStats::Snapshot rates;
+        bool paceKnown = false;
+        float paceDelta = 0.0f;
+        int pendingGarbage = 0;
+        int undoDepth = 0, redoDepth = 0;
+        bool pieceVisible = true; // false during entry and line-clear delay
+        float arr = 0.0f, das = 0.0f, dcd = 0.0f, sdf = 0.0f;
+        std::string mode; // settings are read here, Settings::reload() may replace them meanwhile
+        char blockCharacter = ' ';
+        std::vector<std::string> popupLines;
+        size_t popupMaxLen = 0;
+        std::chrono::steady_clock::time_point popupStartTime;
+        float popupDurationSeconds = 0.0f;
+    };
+    TripleBuffer<Frame> frames;
+    std::array<uint32_t, REGION_COUNT> revision{}; // engine side
+    uint64_t publishedFrames = 0;
+    std::chrono::steady_clock::time_point lastPublish;
+    // the render thread draws at ~60 FPS, quiet steps in between publish nothing
+    static constexpr std::chrono::milliseconds PUBLISH_INTERVAL{16};
+    void publish(); // only when something is dirty or PUBLISH_INTERVAL passed
+
+    // single-player games draw on their own thread, so a terminal that blocks on output never
+    // delays input, gravity or lock delay; versus still steps and draws on one thread
+    std::thread renderer;
+    std::atomic<bool> rendering{false};
+    std::atomic<bool> redrawRequested{true};   // invalidate(), from any thread
+    std::atomic<bool> relayoutRequested{true}; // resize, viewport or mode change
+    void startRenderer();
+    void stopRenderer(); // draws one last frame before returning
+    void renderLoop();
+
+    // render side only
+    unsigned redraw = DIRTY_ALL; // regions to draw this frame
+    std::array<uint32_t, REGION_COUNT> drawnRevision{};
+    bool popupShown = false;
+    bool overlayShown = false;
+    int lastHudTick = -1;
+    int renderedLevel = 0; // OutputMonitor level the windows were last drawn at
+    int64_t lastLinkUpdate = 0;
+    int viewportX = 0;
+    int viewportWidth = 0; // 0 = whole terminal
+    std::string label;
+    int64_t lastFrameStart = 0; // profiler frame interval
+
+    // geometry and static text, rebuilt only per game and on terminal resize
+    enum MainStat { STAT_NONE, STAT_LINES, STAT_LINES_LEFT, STAT_ATTACK, STAT_FAULTS, STAT_TIME_LEFT, STAT_CHEESE_LEFT, STAT_UNDO, STAT_LEVEL };
+    struct Layout {
+        bool valid = false;
+        bool fits = false; // false when the board itself does not fit, only a notice is shown
+        int popupWidth = 0;
+        std::string title;
+        MainStat mainStat = STAT_NONE;
+        int statTarget = 0;
+        double statTimeLimit = 0.0;
+        char shownStat[32] = ""; // last main stat written, skipped when unchanged
+        char shownLink[32] = ""; // last output stats line written
+        // optional panels stay null when they would fall outside the viewport
+        WINDOW* boardwin = nullptr;
+        WINDOW* holdwin = nullptr;
+        WINDOW* statswin = nullptr;
+        WINDOW* rateswin = nullptr;
+        WINDOW* nextwin = nullptr;
+        WINDOW* handlingwin = nullptr;
+        WINDOW* titlewin = nullptr;
+        WINDOW* mainstatwin = nullptr;
+        WINDOW* popupwin = nullptr;
+        WINDOW* meterwin = nullptr;
+        WINDOW* noticewin = nullptr;
+        WINDOW* linkwin = nullptr; // output rate line, shown while profiling or degraded
+    } layout;
 
     void handleInput(const Settings& settings, int ch);
+    void applySettings(const Settings& settings); // handling and hold estimation, per game and on reload
+    void hold();
+    void hardDrop();
+    void recordPlacement(); // practice only, after a piece locks and the next one spawns
+    PracticeHistory::State packState();
+    void restoreState(const PracticeHistory::State& state);
+    void playBotMove();
     void clearLines();
-    void processLineClear();
+    int processLineClear(); // lines cleared by the piece just placed
+    void applyGarbage();
+    // L/R shift on press, l/r autorepeat shift, D soft drop, C/W/F cw/ccw/180, H hold, V hard drop
+    void noteInput(char action);
+    void clearPieceInputs();
+    void logPiece(const GameUtils::ClearInfo& info, int attack);
+    void checkFinesse();
     void generatePopup(const GameUtils::ClearInfo& info);
     void showPopup(const std::string& text, float durationSeconds = 2.0);
+    void computeLayout(const Frame& frame);
+    void releaseWindows();
 };
 
 #endif
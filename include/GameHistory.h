@@ -0,0 +1,86 @@
+#ifndef GAME_HISTORY_H
+#define GAME_HISTORY_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+// every finished game as one fixed-size record in an append-only log, plus a summary that
+// has the log folded into it: lifetime totals and per-mode bests. The summary remembers how
+// much of the log it covers, so opening it only folds in games appended since (compaction),
+// and answering "clitris stats" never depends on how many games were played
+class GameHistory {
+public:
+    GameHistory() = delete;
+
+    static constexpr uint32_t MAGIC = 0x48474c43; // "CLGH"
+    static constexpr uint32_t VERSION = 1;
+    static constexpr int COUNTER_COUNT = 20; // see counterNames in GameHistory.cpp
+    static constexpr int MAX_MODES = 24;
+    // Record::counters indices read by name elsewhere (curses already defines LINES)
+    enum Counter { COUNTER_PIECES = 0, COUNTER_ATTACK = 1, COUNTER_LINES = 2, COUNTER_SINGLE = 3,
+                   COUNTER_TETRIS = 6, COUNTER_TSPINS = 7, COUNTER_PC = 12, COUNTER_MAX_B2B = 13,
+                   COUNTER_MAX_COMBO = 14, COUNTER_SCORE = 15, COUNTER_CHEESE = 16, COUNTER_FINESSE = 17 };
+
+    struct Record {
+        char mode[16];
+        int64_t finishedAt; // ms since epoch
+        double time;        // seconds, paused time excluded
+        uint32_t seed;      // piece generator seed
+        float pps;
+        float apm;
+        uint8_t completed;  // reached the mode's goal, not topped out or quit
+        uint8_t reserved[3];
+        int32_t counters[COUNTER_COUNT];
+        uint32_t checksum; // crc32 of everything before it
+    };
+
+    struct ModeSummary {
+        char mode[16]; // empty for unused slots
+        uint64_t games;
+        double seconds;
+        double bestTime; // fastest completed game, 0 when none
+        int32_t bestScore;
+        int32_t bestLines;
+        float bestPps;
+        float bestApm;
+    };
+
+    struct Summary {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t coveredBytes; // length of the log folded in below
+        uint64_t games;
+        double seconds;
+        int64_t counters[COUNTER_COUNT];
+        ModeSummary modes[MAX_MODES];
+        uint32_t reserved;
+        uint32_t checksum; // crc32 of everything before it
+    };
+
+    // Game's statistic name for Record::counters[index]
+    static const char* counterName(int index);
+
+    // appends a finished game and folds it into the summary
+    static bool record(const std::string& mode, uint32_t seed, double time, bool completed,
+                       const std::unordered_map<std::string, int>& statistics);
+
+    // lifetime totals, including games other instances recorded since this one last looked
+    static const Summary& totals();
+
+    // "clitris stats": lifetime totals and per-mode bests, optionally the most recent games;
+    // rebuild refolds the whole log instead of trusting the summary. Returns an exit status
+    static int report(int recent, const std::string& mode, bool rebuild);
+private:
+    static Summary summary;
+    static bool loaded;
+
+    static std::string logPath();
+    static std::string summaryPath();
+    static void load(bool rebuild);
+    static void fold(const Record& record);
+    static void foldLog(int fd, uint64_t size); // maps the log and folds everything past coveredBytes
+    static bool saveSummary();
+};
+
+#endif
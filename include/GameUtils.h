@@ -2,6 +2,7 @@
 #define GAME_UTILS_H
 
 #include <atomic>
+#include <random>
 #include <thread>
 #include <vector>
 
@@ -20,7 +21,7 @@ public:
         int cheeseCleared = 0;
     };
 
-    static std::vector<Tetromino> generateBag();
+    static std::vector<Tetromino> generateBag(std::mt19937& rng);
     static bool canPlace(const Tetromino& piece, const std::vector<std::vector<int>>& board);
     static void placePiece(const Tetromino& piece, std::vector<std::vector<int>>& board);
     
@@ -33,6 +34,14 @@ public:
     static int calculateAttack(const ClearInfo& info, int b2bStreak, int combo);
     static int calculateScore(const ClearInfo& info, int b2bStreak, int combo);
     static void generateCheeseLines(std::vector<std::vector<int>>& board, int num);
+    static void generateGarbageLines(std::vector<std::vector<int>>& board, int num);
+
+    // level progression for marathon and master: a level every 10 lines
+    static constexpr int LINES_PER_LEVEL = 10;
+    static constexpr double INSTANT_GRAVITY = 20.0 * 60.0 / 1000.0; // 20G, in rows per ms
+    static int levelForLines(int lines) { return 1 + lines / LINES_PER_LEVEL; }
+    // guideline speed curve, (0.8 - (level - 1) * 0.007)^(level - 1) seconds per row, in rows per ms
+    static double levelGravity(int level);
 };
 
 #endif
@@ -0,0 +1,37 @@
+#ifndef HOLD_ESTIMATOR_H
+#define HOLD_ESTIMATOR_H
+
+#include <chrono>
+#include <vector>
+
+#include "InputReader.h"
+
+// infers press/repeat/release for terminals that only send key presses, using the
+// terminal's measured autorepeat delay and interval (see Settings::calibrateKeyRepeat)
+class HoldEstimator {
+public:
+    void configure(float repeatDelayMs, float repeatIntervalMs);
+    void track(int key); // only tracked keys are rewritten, everything else passes through
+    void untrackAll() { keys.clear(); }
+    void reset();
+
+    // copies in to out with tracked keys tagged as PRESS or REPEAT, plus a RELEASE
+    // for every tracked key whose repeats stopped arriving on schedule
+    void process(const std::vector<InputEvent>& in, std::vector<InputEvent>& out,
+                 std::chrono::steady_clock::time_point now);
+private:
+    struct Key {
+        int code;
+        bool down = false;
+        int repeats = 0;
+        std::chrono::steady_clock::time_point lastSeen;
+    };
+    std::vector<Key> keys;
+    double delayMs = 250.0;
+    double intervalMs = 33.0;
+
+    double expectedGap(const Key& key) const { return key.repeats == 0 ? delayMs : intervalMs; }
+    double tolerance(const Key& key) const;
+};
+
+#endif
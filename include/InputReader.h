@@ -0,0 +1,65 @@
+#ifndef INPUT_READER_H
+#define INPUT_READER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "SpscQueue.h"
+
+struct InputEvent {
+    enum Type : uint8_t { PRESS, REPEAT, RELEASE }; // repeat/release only with the kitty protocol
+    int key; // curses key code
+    std::chrono::steady_clock::time_point time; // when the bytes arrived on stdin
+    Type type = PRESS;
+};
+
+// background thread that owns stdin while a game is running: it blocks on the terminal,
+// decodes escape sequences into curses key codes and timestamps each key as it arrives
+class InputReader {
+public:
+    InputReader() = delete;
+
+    static void start();
+    static void stop();
+    static bool active() { return running.load(std::memory_order_relaxed); }
+
+    // kitty keyboard protocol: asked for on start, only enabled once the terminal answers
+    static void setKeyboardProtocol(bool allowed) { protocolAllowed = allowed; }
+    static bool reportsReleases() { return enhanced.load(std::memory_order_relaxed); }
+    static void restoreTerminal(); // async-signal-safe
+
+    // synchronized output (mode 2026), known once the terminal answers the mode query
+    static bool synchronizedOutput() { return syncOutput.load(std::memory_order_relaxed); }
+
+    // engine thread only; moves every pending event into out
+    static void drain(std::vector<InputEvent>& out);
+    // engine thread only; sleeps until deadline, or less when a key arrives meanwhile
+    static void waitForInput(std::chrono::steady_clock::time_point deadline);
+    // thread that draws only: switches keyboard mode and resizes curses between frames,
+    // true when the terminal size changed since the last call
+    static bool applyTerminalChanges();
+private:
+    static SpscQueue<InputEvent, 256> queue;
+    static std::thread reader;
+    static std::atomic<bool> running;
+    static bool protocolAllowed;
+    static std::atomic<bool> protocolAnswered;
+    static std::atomic<bool> enhanced;
+    static std::atomic<bool> syncOutput;
+    static std::atomic<bool> resized;
+    static std::mutex wakeMutex;
+    static std::condition_variable wake;
+    static bool keyPending; // guarded by wakeMutex, set on push and cleared by waitForInput
+
+    static void readLoop();
+    static size_t decode(const unsigned char* bytes, size_t length, bool more, int& key, InputEvent::Type& type);
+    static int decodeKittyKey(int code, int modifiers);
+    static void push(int key, InputEvent::Type type, std::chrono::steady_clock::time_point time);
+};
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef LEADERBOARD_H
+#define LEADERBOARD_H
+
+#include <cstdint>
+#include <string>
+
+// finished sprint runs: every run is appended to a log of fixed-size records and never
+// rewritten, a small index next to it holds the best run per mode and how much of the log it
+// covers, so startup reads the index plus whatever was appended after it was last written
+class Leaderboard {
+public:
+    Leaderboard() = delete;
+
+    static constexpr uint32_t MAGIC = 0x42444c43; // "CLDB"
+    static constexpr uint32_t VERSION = 1;
+    static constexpr int SPLIT_LINES = 10; // a split every this many lines
+    static constexpr int MAX_SPLITS = 10;  // sprint 100L
+    static constexpr int MAX_MODES = 8;
+
+    struct Run {
+        char mode[16];
+        int64_t finishedAt; // ms since epoch
+        double time;        // seconds, paused time excluded
+        double splits[MAX_SPLITS]; // game time when each SPLIT_LINES were reached
+        uint32_t splitCount;
+        uint32_t checksum; // crc32 of everything before it
+    };
+
+    struct Index {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t coveredBytes; // length of the log the entries below account for
+        uint64_t runCount;
+        Run best[MAX_MODES]; // empty mode name for unused slots
+        uint32_t reserved;
+        uint32_t checksum; // crc32 of everything before it
+    };
+
+    // reads the index and catches up on runs appended after it, rebuilding it when missing
+    static void load();
+    // null when the mode has no finished run yet
+    static const Run* personalBest(const std::string& mode);
+    // appends the run and updates the index; true when it is a new personal best
+    static bool record(Run run);
+private:
+    static Index index;
+
+    static std::string logPath();
+    static std::string indexPath();
+    static uint32_t runChecksum(const Run& run);
+    static bool consider(const Run& run); // true when run became its mode's best
+    static void scan(int fd, uint64_t from, uint64_t to);
+    static bool saveIndex();
+};
+
+#endif
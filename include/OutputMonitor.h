@@ -0,0 +1,36 @@
+#ifndef OUTPUT_MONITOR_H
+#define OUTPUT_MONITOR_H
+
+#include <cstddef>
+#include <cstdint>
+
+// watches how fast the tty drains what we write and steps rendering down on slow links:
+// level 1 slows the HUD, level 2 also drops the ghost piece, level 3 also drops colors
+class OutputMonitor {
+public:
+    OutputMonitor() = delete;
+
+    enum Level { FULL, SLOW_HUD, NO_GHOST, MONOCHROME };
+
+    static void setEnabled(bool enabled) { adaptive = enabled; }
+
+    // called once per flushed frame; bytes is 0 when the renderer cannot count them
+    static void frameWritten(size_t bytes, int64_t flushMicros);
+    static Level level() { return current; }
+
+    // over the last full second
+    static double bytesPerSecond() { return rateBytes; }
+    static bool bytesKnown() { return countedBytes; }
+    static double framesPerSecond() { return rateFrames; }
+    static int queuedBytes() { return queued; }
+private:
+    static bool adaptive;
+    static Level current;
+    static int queued;
+    static int64_t windowStart, windowBytes, windowFrames;
+    static double rateBytes, rateFrames;
+    static bool countedBytes;
+    static int64_t lastChange, congestedSince, clearSince;
+};
+
+#endif
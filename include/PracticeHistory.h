@@ -0,0 +1,47 @@
+#ifndef PRACTICE_HISTORY_H
+#define PRACTICE_HISTORY_H
+
+#include <cstdint>
+#include <vector>
+
+#include "Bitboard.h"
+
+// undo/redo for practice mode: a fixed ring of packed game states, one per placement;
+// every state has the same small size, so undo and redo are an index step and one copy
+// no matter how long the session has been
+class PracticeHistory {
+public:
+    static constexpr int CAPACITY = 1024; // oldest placements fall off beyond this
+    static constexpr int QUEUE_LENGTH = 14; // the bag never holds more than two sets
+    static constexpr int STAT_COUNT = 19;
+
+    struct State {
+        uint8_t cells[Bitboard::HEIGHT * Bitboard::WIDTH / 2]; // two 4-bit colors per byte
+        char current; // spawns fresh on restore
+        char held;    // 0 = empty
+        uint8_t holdAvailable;
+        uint8_t queueLength;
+        char queue[QUEUE_LENGTH];
+        int32_t stats[STAT_COUNT]; // in Game's statistic order
+        uint32_t bagsDealt; // generator position, replayed from the game's seed on restore
+    };
+
+    void clear();
+    // makes state the newest entry; anything that could still be redone is dropped
+    void push(const State& state);
+    // the state to restore, or null when there is nothing to step to
+    const State* undo();
+    const State* redo();
+
+    int undoDepth() const { return cursor; }
+    int redoDepth() const { return count - 1 - cursor; }
+private:
+    std::vector<State> ring; // allocated on first use, only practice games pay for it
+    int oldest = 0;
+    int count = 0;
+    int cursor = -1; // entry the game currently shows, counted from oldest
+
+    const State& at(int index) const { return ring[(oldest + index) % CAPACITY]; }
+};
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <curses.h>
+
+// frame-time and input-latency histograms; recording is lock-free so any thread may sample
+class Profiler {
+public:
+    Profiler() = delete;
+
+    enum Metric {
+        UPDATE,        // Game::update
+        RENDER,        // Game::render, staging windows for the frame
+        OUTPUT,        // UI::flushFrame, the single terminal write per frame
+        INPUT_LATENCY, // key read from stdin -> applied to the engine
+        FRAME,         // frame-to-frame interval
+        BYTES,         // bytes written per frame, in bytes not microseconds (ansi renderer only)
+        METRIC_COUNT
+    };
+
+    static void setEnabled(bool enabled) { recording = enabled; }
+    static bool isEnabled() { return recording || overlay; }
+    static void setReportPath(const std::string& path) { reportPath = path; }
+    static void toggleOverlay();
+    static bool overlayVisible() { return overlay; }
+
+    static int64_t now() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+    static void record(Metric metric, int64_t micros);
+    static int64_t percentile(Metric metric, double p);
+    static int64_t max(Metric metric);
+    static uint64_t samples(Metric metric);
+    static void clear();
+
+    // arrival is the timestamp the input thread gave the key
+    static void inputApplied(std::chrono::steady_clock::time_point arrival);
+
+    static void renderOverlay();
+    static void hideOverlay();
+    static void writeReport();
+
+    class Scope {
+    public:
+        explicit Scope(Metric metric) : metric(metric), start(isEnabled() ? now() : 0) {}
+        ~Scope() { if (start) record(metric, now() - start); }
+    private:
+        Metric metric;
+        int64_t start;
+    };
+private:
+    // log-linear buckets: exact below 32us, then 16 sub-buckets per power of two
+    static constexpr int LINEAR_BUCKETS = 32;
+    static constexpr int SUB_BUCKETS = 16;
+    static constexpr int BUCKET_COUNT = LINEAR_BUCKETS + 40 * SUB_BUCKETS;
+
+    struct Histogram {
+        std::atomic<uint64_t> counts[BUCKET_COUNT];
+        std::atomic<uint64_t> total{0};
+        std::atomic<int64_t> sum{0};
+        std::atomic<int64_t> maximum{0};
+    };
+
+    static Histogram histograms[METRIC_COUNT];
+    static std::atomic<bool> recording;
+    static std::atomic<bool> overlay;
+    static std::string reportPath;
+    static WINDOW* overlayWin;
+    static int64_t lastOverlayDraw;
+
+    static int bucketFor(int64_t micros);
+    static int64_t bucketValue(int bucket);
+};
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef RECORD_LOG_H
+#define RECORD_LOG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// storage shared by Leaderboard and GameHistory: an append-only log of fixed-size records,
+// plus a cache file next to it holding one struct folded from the log (an index, a summary).
+// Appends hold an exclusive lock from the tail scan to the write and readers a shared one,
+// so instances running side by side never truncate or overwrite each other's records
+class RecordLog {
+public:
+    RecordLog() = delete;
+
+    // the log opened and locked, shared for reading or exclusive for appending (then created
+    // along with its directories); -1 when it cannot be opened
+    static int openLog(const std::string& path, bool append);
+    static void closeLog(int fd); // also drops the lock
+    static uint64_t logSize(int fd);
+    static bool readAll(int fd, void* bytes, size_t length);
+    // cuts the log back to end, dropping a torn record left by a crash, and appends one
+    // record there, synced before returning
+    static bool append(int fd, uint64_t end, const void* record, size_t length);
+
+    // the cache holds exactly length bytes, a short or missing file is not loaded; it can
+    // always be refolded from the log, so saving writes a temporary file and renames it over
+    // without syncing
+    static bool loadCache(const std::string& path, void* bytes, size_t length);
+    static bool saveCache(const std::string& path, const void* bytes, size_t length);
+};
+
+#endif
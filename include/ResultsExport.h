@@ -0,0 +1,46 @@
+#ifndef RESULTS_EXPORT_H
+#define RESULTS_EXPORT_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#include "GameHistory.h"
+#include "Leaderboard.h"
+
+// final results of every game, one line each, as json lines or csv for external tools; lines
+// are formatted straight into a large static stdio buffer, so writing millions of bot games
+// costs no allocation per record
+class ResultsExport {
+public:
+    ResultsExport() = delete;
+
+    enum Format { FORMAT_JSONL, FORMAT_CSV };
+
+    struct Result {
+        const char* mode;
+        int64_t finishedAt; // ms since epoch
+        uint32_t seed;      // piece generator seed
+        double time;        // seconds
+        bool completed;
+        int place;          // royale finishing place, 0 elsewhere
+        float arr, das, dcd, sdf; // handling, 0 for bots
+        int32_t counters[GameHistory::COUNTER_COUNT]; // named by GameHistory::counterName
+        uint32_t untracked; // a bit per counter the source does not keep, written empty or null
+        double splits[Leaderboard::MAX_SPLITS];
+        int splitCount;
+    };
+
+    static Format formatForPath(const std::string& path); // csv for a .csv file, json lines otherwise
+    static bool open(const std::string& path, Format format);
+    static bool isEnabled() { return file != nullptr; }
+    static void write(const Result& result);
+    static void flush(); // after each finished game, records are otherwise only buffered
+    static void close();
+private:
+    static FILE* file;
+    static Format format;
+    static char buffer[1 << 20];
+};
+
+#endif
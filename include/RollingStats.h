@@ -0,0 +1,65 @@
+#ifndef ROLLING_STATS_H
+#define ROLLING_STATS_H
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// pps, apm and vs over sliding windows (the last 5 s, 30 s and 100 pieces) from a fixed ring of
+// lock records; each window keeps running sums and a tail that only moves forward, so a lock
+// and a read are both O(1) however long the game runs
+class RollingStats {
+public:
+    static constexpr int CAPACITY = 512; // locks kept, a time window never reaches further back
+    static constexpr int PIECE_WINDOW = 100;
+    static constexpr int TIMELINE_BUCKETS = 40; // columns of the results page sparkline
+
+    struct Rate {
+        float pps = 0.0f;
+        float apm = 0.0f;
+        float vs = 0.0f; // (attack + garbage cleared) per 100 seconds
+    };
+    struct Snapshot {
+        Rate lastSeconds5;
+        Rate lastSeconds30;
+        Rate lastPieces; // over the last PIECE_WINDOW locks
+    };
+
+    void clear();
+    // time is game time in seconds, paused time excluded
+    void record(double time, int attack, int garbageCleared);
+    // drops records that slid out of the time windows, so it is not const
+    Snapshot rates(double now);
+
+    // pieces per second across the whole game, oldest bucket first; the buckets double in
+    // width whenever the game outgrows them, so the chart always spans the full game
+    std::vector<float> timeline(double now) const;
+private:
+    struct Lock {
+        double time;
+        int16_t attack;
+        int16_t garbage;
+    };
+    std::array<Lock, CAPACITY> ring{};
+    uint64_t written = 0; // locks recorded, the newest is at (written - 1) % CAPACITY
+
+    struct Window {
+        double seconds;
+        uint64_t tail = 0; // oldest lock still inside
+        double floor = 0.0; // time of the newest lock the ring overwrote while still inside
+        int attack = 0;
+        int garbage = 0;
+    };
+    Window window5{5.0};
+    Window window30{30.0};
+    int pieceAttack = 0, pieceGarbage = 0; // sums over the last PIECE_WINDOW locks
+
+    std::array<uint32_t, TIMELINE_BUCKETS> buckets{}; // locks per bucket
+    double bucketSeconds = 1.0;
+
+    const Lock& at(uint64_t index) const { return ring[index % CAPACITY]; }
+    void slide(Window& window, double now);
+    static Rate rate(int pieces, int attack, int garbage, double seconds);
+};
+
+#endif
@@ -1,18 +1,32 @@
 #ifndef SETTINGS_H
 #define SETTINGS_H
 
+#include <cstdint>
 #include <string>
-#include <unordered_map>
-#include <vector>
+
+#include "SettingsStore.h"
 
 class Settings {
 public:
+    // same order as the key lists in the settings file
+    enum Action {
+        ACTION_LEFT, ACTION_RIGHT, ACTION_ROTATE_CW, ACTION_ROTATE_CCW, ACTION_FLIP, ACTION_HOLD,
+        ACTION_SOFT_DROP, ACTION_HARD_DROP, ACTION_PAUSE, ACTION_QUIT, ACTION_RESTART, ACTION_COUNT
+    };
+    static_assert(ACTION_COUNT == SettingsStore::ACTION_COUNT, "store keeps one key list per action");
+
     static void configure();
-    static std::unordered_map<std::string, std::vector<int>> getKeyBindings();
-    static float getARR() { return ARR; }
-    static float getDAS() { return DAS; }
-    static float getDCD() { return DCD; }
-    static float getSDF() { return SDF; }
+    static const SettingsStore::KeyList& getKeys(Action action) { return profile().keys[action]; }
+    static const char* actionName(Action action);
+    static float getARR() { return profile().arr; }
+    static float getDAS() { return profile().das; }
+    static float getDCD() { return profile().dcd; }
+    static float getSDF() { return profile().sdf; }
+    static bool getHoldEstimation() { return profile().holdEstimation != 0; }
+    static float getRepeatDelay() { return profile().repeatDelay; }
+    static float getRepeatInterval() { return profile().repeatInterval; }
+    static float getARE() { return profile().areFrames * 1000.0f / 60.0f; } // ms
+    static float getLineClearDelay() { return profile().lineClearFrames * 1000.0f / 60.0f; } // ms
     static std::string getMode() { return mode; }
 
     static void setMode(const std::string& newMode) {
@@ -22,27 +36,37 @@ public:
     static void saveConfig();
     static void loadConfig();
 
+    // live reload: the store is watched for writes from other processes (another clitris
+    // in its settings screen, a script), and reload() adopts the newest one on the main thread
+    static void watchConfig();
+    static bool reload();
+    static uint32_t generation() { return reloadGeneration; } // bumped by every adopted reload
+
+    // measures the terminal's key autorepeat while the player holds a key
+    static bool calibrateKeyRepeat();
+
     static char getTetrominoCharacter() {
-        return tetrominoCharacter;
+        return profile().tetrominoCharacter;
     }
 
     static void setTetrominoCharacter(const char character) {
-        tetrominoCharacter = character;
+        profile().tetrominoCharacter = character;
     }
 
+    static std::string getUserDataPath();
+
 private:
-    static float ARR; // auto repeat rate
-    static float DAS; // delayed auto shift
-    static float DCD; // das cut delay
-    static float SDF; // soft drop factor
+    // every handling setting and key binding, exactly as stored on disk;
+    // the active profile holds ARR, DAS, DCD, SDF, the bindings and the legacy input options
+    static SettingsStore::Data store;
 
     static std::string mode;
+    static uint32_t reloadGeneration;
 
-    static std::unordered_map<std::string, std::vector<int>> keyBindings;
-
-    static char tetrominoCharacter;
-
-    static std::string getUserDataPath();
+    static SettingsStore::Profile& profile() { return store.profiles[store.activeProfile]; }
+    static void setDefaults();
+    // reads the settings.bin stream written before the store existed
+    static bool loadLegacy(const std::string& file);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,71 @@
+#ifndef SETTINGS_STORE_H
+#define SETTINGS_STORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// on-disk layout of the settings file: one fixed-size record in host byte order behind a
+// checksummed header, so loading is a mapping and a copy rather than a parse
+class SettingsStore {
+public:
+    SettingsStore() = delete;
+
+    static constexpr uint32_t MAGIC = 0x53544c43; // "CLTS"
+    static constexpr uint32_t VERSION = 4; // 1 and 2 were the unchecked stream format, 3 had lifetime totals
+    static constexpr int MAX_PROFILES = 4;
+    static constexpr int ACTION_COUNT = 11;
+    static constexpr int MAX_KEYS = 8; // per action
+
+    struct KeyList {
+        uint32_t count;
+        int32_t keys[MAX_KEYS];
+
+        const int32_t* begin() const { return keys; }
+        const int32_t* end() const { return keys + count; }
+        bool contains(int key) const {
+            for (uint32_t i = 0; i < count; ++i) {
+                if (keys[i] == key) return true;
+            }
+            return false;
+        }
+    };
+
+    struct Profile {
+        char name[16];
+        float arr, das, dcd, sdf; // ms
+        KeyList keys[ACTION_COUNT]; // indexed by Settings::Action
+        float repeatDelay, repeatInterval; // measured terminal autorepeat, ms
+        uint8_t holdEstimation;
+        char tetrominoCharacter;
+        // entry delay (ARE) and line-clear delay in 60 Hz frames; formerly reserved and
+        // zeroed, so older stores load with both delays off
+        uint8_t areFrames;
+        uint8_t lineClearFrames;
+    };
+
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t size;     // of the whole record, header included
+        uint32_t checksum; // crc32 of everything after the header
+    };
+
+    struct Data {
+        Header header;
+        uint32_t activeProfile;
+        uint32_t profileCount;
+        Profile profiles[MAX_PROFILES];
+    };
+
+    static constexpr size_t V3_LIFETIME_BYTES = 40; // games, pieces, lines, attack, seconds
+
+    // maps the file and copies it out if the header, size and checksum all check out; a version 3
+    // file loads with its trailing lifetime totals dropped
+    static bool load(const std::string& path, Data& data);
+    // writes a temporary file next to path and renames it over, so a crash keeps the old file
+    static bool save(const std::string& path, Data& data);
+    static uint32_t crc32(const void* bytes, size_t length);
+};
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+#include "SpscQueue.h"
+
+// per-piece csv log; the game thread only pushes into a queue, a background thread does the disk io
+class Telemetry {
+public:
+    Telemetry() = delete;
+
+    static constexpr int MAX_INPUTS = 23;
+
+    struct PieceRecord {
+        int64_t game;   // start time of the game in ms since epoch
+        char mode[16];
+        int piece;      // index within the game
+        char type;
+        int8_t x, y, rotation; // final pose
+        uint8_t inputCount;
+        char inputs[MAX_INPUTS + 1]; // see Game::noteInput for the letters
+        uint32_t lockMs; // spawn to lock
+        uint8_t lines, attack;
+        bool tspin, mini, pc;
+        int16_t b2b, combo; // streaks after this piece
+    };
+
+    static bool open(const std::string& path);
+    static bool isEnabled() { return file != nullptr; }
+    static void record(const PieceRecord& piece);
+    static void close();
+    static uint64_t dropped() { return droppedCount.load(std::memory_order_relaxed); }
+private:
+    static SpscQueue<PieceRecord, 1024> queue;
+    static FILE* file;
+    static std::thread writer;
+    static std::atomic<bool> writing;
+    static std::atomic<uint64_t> droppedCount;
+
+    static void writerLoop();
+    static void writeRecord(const PieceRecord& piece);
+};
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// fixed set of workers that split index ranges into contiguous batches
+class ThreadPool {
+public:
+    explicit ThreadPool(int threads = 0); // 0 = one per hardware thread
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int size() const { return (int)workers.size() + 1; } // the calling thread helps too
+
+    // runs fn(begin, end) over [0, count) and blocks until every batch is done
+    void parallelFor(int count, const std::function<void(int, int)>& fn);
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    const std::function<void(int, int)>* job = nullptr;
+    int jobCount = 0;
+    int batches = 0;
+    int nextBatch = 0;
+    int finished = 0;
+    unsigned generation = 0;
+    bool stopping = false;
+
+    void workerLoop();
+    void runBatches();
+};
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// chrome trace_event recorder (open the output in Perfetto or chrome://tracing)
+// every thread writes into its own preallocated ring, so recording never locks or allocates
+class Trace {
+public:
+    Trace() = delete;
+
+    static constexpr int RING_CAPACITY = 1 << 16; // events kept per thread, oldest are overwritten
+
+    static void setOutput(const std::string& path);
+    static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+    // allocates the calling thread's ring up front; otherwise done on its first event
+    static void registerThread(const char* name);
+
+    static int64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+    // names must be string literals, only the pointer is stored
+    static void complete(const char* name, int64_t start, int64_t end);
+    static void instant(const char* name);
+
+    static void write();
+
+    class Span {
+    public:
+        explicit Span(const char* name) : name(name), start(isEnabled() ? now() : 0) {}
+        ~Span() { if (start) complete(name, start, now()); }
+    private:
+        const char* name;
+        int64_t start;
+    };
+private:
+    struct Event {
+        const char* name;
+        int64_t start;    // ns
+        int64_t duration; // ns, -1 for instant events
+    };
+    struct Ring;
+
+    static std::atomic<bool> enabled;
+    static std::string outputPath;
+    static int64_t startTime;
+
+    // rings outlive their threads so write() can still read them at exit; a thread that exits
+    // hands its ring back, and the next thread registering under the same name carries on in it
+    struct RingHandle {
+        Ring* ring = nullptr;
+        ~RingHandle();
+    };
+    static std::mutex ringsMutex;
+    static std::vector<std::unique_ptr<Ring>> rings;
+    static thread_local RingHandle currentRing;
+
+    static Ring* threadRing();
+    static Ring* acquireRing(const char* name); // a released ring of that name, or a new one
+};
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <atomic>
+#include <cstdint>
+
+// lock-free triple buffer for exactly one writer thread and one reader thread: the writer fills
+// its own slot and swaps it with the shared middle one, the reader swaps the middle for its own
+// only when something newer was published, so neither side ever waits for the other
+template <typename T>
+class TripleBuffer {
+public:
+    // writer: fill back(), which still holds whatever was last published from that slot, then
+    // publish() it
+    T& back() { return slots[backIndex]; }
+    void publish() {
+        backIndex = middle.exchange(backIndex | FRESH, std::memory_order_acq_rel) & INDEX;
+    }
+
+    // reader: takes the newest published value into front(), false when nothing new arrived
+    bool update() {
+        if (!(middle.load(std::memory_order_relaxed) & FRESH)) return false;
+        frontIndex = middle.exchange(frontIndex, std::memory_order_acq_rel) & INDEX;
+        return true;
+    }
+    const T& front() const { return slots[frontIndex]; }
+private:
+    static constexpr uint8_t INDEX = 3;
+    static constexpr uint8_t FRESH = 4; // the middle slot holds a value the reader has not taken
+
+    T slots[3];
+    // each side's index on its own cache line, like the spsc queue
+    alignas(64) uint8_t backIndex = 0;
+    alignas(64) std::atomic<uint8_t> middle{1};
+    alignas(64) uint8_t frontIndex = 2;
+};
+
+#endif
@@ -5,16 +5,40 @@
 #include <string>
 
 #include "Tetromino.h"
+#include "RollingStats.h"
 
 class UI {
 public:
-    static void renderBoard(WINDOW* win, const std::vector<std::vector<int>>& board, int board_height, int board_width, int cell_width = 2);
-    static void renderTetromino(WINDOW* win, const Tetromino& tetromino, int cell_width = 2, bool ghost = false);
+    static void renderBoard(WINDOW* win, const std::vector<std::vector<int>>& board, char block, int board_height, int board_width, int cell_width = 2);
+    static void renderTetromino(WINDOW* win, const Tetromino& tetromino, char block, int cell_width = 2, bool ghost = false);
     static void renderGhostPiece(WINDOW* win, const Tetromino& tetromino, const std::vector<std::vector<int>>& board, int cell_width = 2);
-    static void renderPieceBox(WINDOW* win, const Tetromino& tetromino, int cell_width = 2);
+    static void renderPieceBox(WINDOW* win, const Tetromino& tetromino, char block, int cell_width = 2);
     static void renderStatsWindow(WINDOW* win, const std::unordered_map<std::string, int>& statistics, double gameTime = 0.0);
-    static void renderHandling(WINDOW* win);
+    static void renderHandling(WINDOW* win, float arr, float das, float dcd, float sdf);
+    static void renderRatesWindow(WINDOW* win, const RollingStats::Snapshot& rates);
     static std::string formatSeconds(double seconds);
-    static void showResultsPage(const std::string& mode, const std::unordered_map<std::string, int>& statistics, double gameTime = 0.0);
+    // ppsTimeline, when given, is charted as a sparkline under the statistics; extraLines are
+    // label value pairs listed first, such as sprint splits
+    static void showResultsPage(const std::string& mode, const std::unordered_map<std::string, int>& statistics, double gameTime = 0.0,
+                                const std::vector<float>& ppsTimeline = {},
+                                const std::vector<std::pair<std::string, std::string>>& extraLines = {});
+    static void showVersusResults(const std::string& winner,
+                                  const std::string& leftName, const std::unordered_map<std::string, int>& leftStatistics,
+                                  const std::string& rightName, const std::unordered_map<std::string, int>& rightStatistics,
+                                  double gameTime = 0.0);
     static void showPauseScreen();
+    static bool askYesNo(const std::string& question); // blocks until y/Enter or n/q/ESC
+
+    // frames are staged window by window and sent to the terminal in one write per frame,
+    // by doupdate or by the ANSI renderer
+    enum Renderer { RENDER_CURSES, RENDER_ANSI };
+    static void setRenderer(Renderer r) { renderer = r; }
+    static Renderer getRenderer() { return renderer; }
+    static const char* rendererName() { return renderer == RENDER_ANSI ? "ansi" : "curses"; }
+    static void stage(WINDOW* win);
+    static void flushFrame();
+    static void clearScreen(); // clear and refresh, and make the next frame repaint in full
+private:
+    static bool framePending;
+    static Renderer renderer;
 };
\ No newline at end of file
@@ -0,0 +1,24 @@
+#ifndef VERSUS_H
+#define VERSUS_H
+
+#include "Game.h"
+#include "Settings.h"
+
+// split-screen match between two independently stepped engines exchanging garbage
+class Versus {
+public:
+    struct Config {
+        bool humanPlayer = true; // false = bot vs bot
+        float playerPps = 2.0f;  // only used when the left side is a bot
+        float opponentPps = 1.5f;
+    };
+
+    void run(const Settings& settings, const Config& config);
+private:
+    Game players[2];
+    int layoutCols = -1;
+
+    void layout();
+};
+
+#endif
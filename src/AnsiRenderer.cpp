@@ -0,0 +1,139 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <unistd.h>
+
+#include "../include/AnsiRenderer.h"
+
+std::vector<chtype> AnsiRenderer::front;
+std::vector<chtype> AnsiRenderer::back;
+int AnsiRenderer::rows = 0;
+int AnsiRenderer::cols = 0;
+bool AnsiRenderer::repaint = true;
+std::string AnsiRenderer::out;
+
+static const chtype BLANK = ' ';
+static const chtype STYLE_MASK = A_ATTRIBUTES & ~A_ALTCHARSET;
+static const int MAX_REWRITE_GAP = 4; // rewriting a few unchanged cells is cheaper than a cursor move
+
+void AnsiRenderer::resize() {
+    rows = LINES;
+    cols = COLS;
+    front.assign((size_t)rows * cols, BLANK);
+    back.assign((size_t)rows * cols, BLANK);
+    repaint = true;
+}
+
+void AnsiRenderer::invalidate() {
+    std::fill(back.begin(), back.end(), BLANK);
+    repaint = true;
+}
+
+void AnsiRenderer::stage(WINDOW* win) {
+    if (!win) return;
+    if (rows != LINES || cols != COLS) resize();
+    int top, left, height, width;
+    getbegyx(win, top, left);
+    getmaxyx(win, height, width);
+    for (int y = 0; y < height; ++y) {
+        int row = top + y;
+        if (row < 0 || row >= rows) continue;
+        if (!repaint && !is_linetouched(win, y)) continue;
+        chtype* cells = &back[(size_t)row * cols];
+        for (int x = 0; x < width; ++x) {
+            int col = left + x;
+            if (col < 0 || col >= cols) continue;
+            cells[col] = mvwinch(win, y, x);
+        }
+    }
+    untouchwin(win);
+}
+
+void AnsiRenderer::appendAttributes(chtype attributes) {
+    char sgr[64];
+    int n = snprintf(sgr, sizeof(sgr), "\x1b[0");
+    if (attributes & A_BOLD) n += snprintf(sgr + n, sizeof(sgr) - n, ";1");
+    if (attributes & A_DIM) n += snprintf(sgr + n, sizeof(sgr) - n, ";2");
+    if (attributes & A_UNDERLINE) n += snprintf(sgr + n, sizeof(sgr) - n, ";4");
+    if (attributes & A_BLINK) n += snprintf(sgr + n, sizeof(sgr) - n, ";5");
+    if (attributes & (A_REVERSE | A_STANDOUT)) n += snprintf(sgr + n, sizeof(sgr) - n, ";7");
+    short pair = PAIR_NUMBER(attributes);
+    short fg = -1, bg = -1;
+    if (pair > 0 && pair_content(pair, &fg, &bg) == OK) {
+        if (fg >= 0 && fg < 8) n += snprintf(sgr + n, sizeof(sgr) - n, ";%d", 30 + fg);
+        else if (fg >= 8) n += snprintf(sgr + n, sizeof(sgr) - n, ";38;5;%d", fg);
+        if (bg >= 0 && bg < 8) n += snprintf(sgr + n, sizeof(sgr) - n, ";%d", 40 + bg);
+        else if (bg >= 8) n += snprintf(sgr + n, sizeof(sgr) - n, ";48;5;%d", bg);
+    }
+    out.append(sgr, n);
+    out += 'm';
+}
+
+size_t AnsiRenderer::flush(bool synchronized) {
+    if (rows != LINES || cols != COLS) resize();
+    out.clear();
+    if (synchronized) out += "\x1b[?2026h";
+    bool changed = repaint;
+    if (repaint) {
+        out += "\x1b[0m\x1b(B\x1b[2J";
+        std::fill(front.begin(), front.end(), BLANK);
+        repaint = false;
+    }
+
+    // terminal state is unknown at the start of every frame, curses may have drawn in between
+    int cursorY = -1, cursorX = -1;
+    chtype style = ~(chtype)0;
+    bool alternate = false;
+    for (int y = 0; y < rows; ++y) {
+        const chtype* wanted = &back[(size_t)y * cols];
+        chtype* shown = &front[(size_t)y * cols];
+        for (int x = 0; x < cols; ++x) {
+            if (wanted[x] == shown[x]) continue;
+
+            if (cursorY == y && cursorX >= 0 && cursorX < x && x - cursorX <= MAX_REWRITE_GAP &&
+                std::all_of(wanted + cursorX, wanted + x, [&](chtype c) {
+                    return (c & STYLE_MASK) == style && ((c & A_ALTCHARSET) != 0) == alternate;
+                })) {
+                // close gap on the same row: resend the unchanged cells in the current style
+                for (int gap = cursorX; gap < x; ++gap) out += (char)(wanted[gap] & A_CHARTEXT);
+            } else if (cursorY != y || cursorX != x) {
+                char move[24];
+                int n = snprintf(move, sizeof(move), "\x1b[%d;%dH", y + 1, x + 1);
+                out.append(move, n);
+            }
+
+            changed = true;
+            chtype cell = wanted[x];
+            if ((cell & STYLE_MASK) != style) {
+                style = cell & STYLE_MASK;
+                appendAttributes(style);
+            }
+            bool lineDrawing = (cell & A_ALTCHARSET) != 0;
+            if (lineDrawing != alternate) {
+                alternate = lineDrawing;
+                out += alternate ? "\x1b(0" : "\x1b(B";
+            }
+            out += (char)(cell & A_CHARTEXT);
+            shown[x] = cell;
+            cursorY = y;
+            // the last column leaves the cursor in a pending-wrap state, always move after it
+            cursorX = x + 1 < cols ? x + 1 : -1;
+        }
+    }
+
+    if (!changed) return 0;
+    if (alternate) out += "\x1b(B";
+    if (style != ~(chtype)0 && style != 0) out += "\x1b[0m";
+    if (synchronized) out += "\x1b[?2026l";
+
+    size_t written = 0;
+    while (written < out.size()) {
+        ssize_t n = write(STDOUT_FILENO, out.data() + written, out.size() - written);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        written += (size_t)n;
+    }
+    return written;
+}
@@ -0,0 +1,380 @@
+#include <curses.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+#include "../include/BattleRoyale.h"
+#include "../include/Bitboard.h"
+#include "../include/Bot.h"
+#include "../include/GameUtils.h"
+#include "../include/ResultsExport.h"
+
+volatile std::sig_atomic_t BattleRoyale::stopRequested = 0;
+
+void BattleRoyale::requestStop() {
+    stopRequested = 1;
+}
+
+BattleRoyale::BattleRoyale(const Config& config)
+    : config(config),
+      count(std::max(2, config.players)),
+      pool(config.threads),
+      routeRng(config.seed ? config.seed : std::random_device{}()) {
+    reset();
+}
+
+BattleRoyale::Targeting BattleRoyale::parseTargeting(const std::string& name) {
+    return name == "attackers" ? Targeting::ATTACKERS : Targeting::RANDOM;
+}
+
+void BattleRoyale::reset() {
+    rows.assign((size_t)count * Bitboard::HEIGHT, 0);
+    current.assign(count, 0);
+    hold.assign(count, 0);
+    queue.assign((size_t)count * QUEUE_SIZE, 0);
+    queueHead.assign(count, 0);
+    queueSize.assign(count, 0);
+    alive.assign(count, 1);
+    pendingGarbage.assign(count, 0);
+    outgoing.assign(count, 0);
+    target.assign(count, -1);
+    combo.assign(count, 0);
+    b2b.assign(count, 0);
+    pieces.assign(count, 0);
+    linesSent.assign(count, 0);
+    linesCleared.assign(count, 0);
+    clearCounts.assign((size_t)count * 4, 0);
+    perfectClears.assign(count, 0);
+    maxCombo.assign(count, 0);
+    maxB2b.assign(count, 0);
+    score.assign(count, 0);
+    eliminatedRound.assign(count, -1);
+    rngs.clear();
+    rngs.reserve(count);
+    seeds.assign(count, 0);
+    for (int i = 0; i < count; ++i) {
+        seeds[i] = routeRng();
+        rngs.emplace_back(seeds[i]);
+        refillQueue(i);
+        current[i] = popPiece(i);
+    }
+    round = 0;
+}
+
+void BattleRoyale::refillQueue(int i) {
+    static const char types[] = {'I', 'J', 'L', 'O', 'S', 'Z', 'T'};
+    char bag[7];
+    std::copy(types, types + 7, bag);
+    std::shuffle(bag, bag + 7, rngs[i]);
+    char* ring = &queue[(size_t)i * QUEUE_SIZE];
+    for (int k = 0; k < 7; ++k) {
+        ring[(queueHead[i] + queueSize[i]) % QUEUE_SIZE] = bag[k];
+        ++queueSize[i];
+    }
+}
+
+char BattleRoyale::popPiece(int i) {
+    char type = queue[(size_t)i * QUEUE_SIZE + queueHead[i]];
+    queueHead[i] = (queueHead[i] + 1) % QUEUE_SIZE;
+    --queueSize[i];
+    if (queueSize[i] <= 7) refillQueue(i);
+    return type;
+}
+
+char BattleRoyale::peekPiece(int i) const {
+    return queue[(size_t)i * QUEUE_SIZE + queueHead[i]];
+}
+
+int BattleRoyale::aliveCount() const {
+    return (int)std::count(alive.begin(), alive.end(), 1);
+}
+
+void BattleRoyale::stepPlayer(int i) {
+    if (!alive[i]) return;
+    uint16_t* board = &rows[(size_t)i * Bitboard::HEIGHT];
+
+    Bot::Move move = Bot::findMove(board, current[i], hold[i], peekPiece(i));
+    if (!move.valid) {
+        alive[i] = 0;
+        return;
+    }
+
+    char type = current[i];
+    if (move.useHold) {
+        char held = hold[i];
+        hold[i] = type;
+        type = held != 0 ? held : popPiece(i);
+    }
+
+    int y = 20 + Bitboard::dropDistance(board, type, move.rotation, move.x, 20);
+    Bitboard::place(board, type, move.rotation, move.x, y);
+
+    GameUtils::ClearInfo info{};
+    info.lines = Bitboard::clearLines(board);
+    info.pc = info.lines > 0 && Bitboard::isEmpty(board);
+
+    if (info.lines > 0) {
+        int attack = GameUtils::calculateAttack(info, b2b[i], combo[i]);
+        score[i] += GameUtils::calculateScore(info, b2b[i], combo[i]);
+        combo[i] = combo[i] + 1;
+        b2b[i] = (info.lines == 4 || info.pc) ? b2b[i] + 1 : 0;
+        linesCleared[i] += info.lines;
+        ++clearCounts[(size_t)i * 4 + info.lines - 1];
+        if (info.pc) ++perfectClears[i];
+        maxCombo[i] = std::max(maxCombo[i], combo[i]);
+        maxB2b[i] = std::max(maxB2b[i], b2b[i]);
+        // cancel incoming garbage before sending
+        int cancelled = std::min(attack, pendingGarbage[i]);
+        pendingGarbage[i] -= cancelled;
+        outgoing[i] += attack - cancelled;
+    } else {
+        combo[i] = 0;
+        if (pendingGarbage[i] > 0) {
+            int lines = std::min(pendingGarbage[i], GARBAGE_CAP);
+            pendingGarbage[i] -= lines;
+            int hole = std::uniform_int_distribution<>(0, Bitboard::WIDTH - 1)(rngs[i]);
+            if (!Bitboard::addGarbage(board, lines, hole)) {
+                alive[i] = 0;
+            }
+        }
+    }
+
+    ++pieces[i];
+    current[i] = popPiece(i);
+    if (!Bitboard::fits(board, current[i], 0, Bitboard::getSpawnX(current[i]), 20)) {
+        alive[i] = 0;
+    }
+}
+
+int BattleRoyale::pickTarget(int i) {
+    std::vector<int> candidates;
+    if (config.targeting == Targeting::ATTACKERS) {
+        // aim at whoever is being targeted by the most players
+        std::vector<int> attackers(count, 0);
+        for (int j = 0; j < count; ++j) {
+            if (alive[j] && target[j] >= 0) ++attackers[target[j]];
+        }
+        int most = -1;
+        for (int j = 0; j < count; ++j) {
+            if (j == i || !alive[j]) continue;
+            if (attackers[j] > most) {
+                most = attackers[j];
+                candidates.clear();
+            }
+            if (attackers[j] == most) candidates.push_back(j);
+        }
+    } else {
+        for (int j = 0; j < count; ++j) {
+            if (j != i && alive[j]) candidates.push_back(j);
+        }
+    }
+    if (candidates.empty()) return -1;
+    return candidates[std::uniform_int_distribution<size_t>(0, candidates.size() - 1)(routeRng)];
+}
+
+void BattleRoyale::routeAttacks() {
+    for (int i = 0; i < count; ++i) {
+        if (!alive[i] && eliminatedRound[i] < 0) eliminatedRound[i] = round;
+    }
+    for (int i = 0; i < count; ++i) {
+        if (outgoing[i] == 0) continue;
+        if (alive[i]) {
+            target[i] = pickTarget(i);
+            if (target[i] >= 0) {
+                pendingGarbage[target[i]] += outgoing[i];
+                linesSent[i] += outgoing[i];
+            }
+        }
+        outgoing[i] = 0;
+    }
+}
+
+void BattleRoyale::step() {
+    pool.parallelFor(count, [this](int begin, int end) {
+        for (int i = begin; i < end; ++i) stepPlayer(i);
+    });
+    routeAttacks();
+    ++round;
+    placements = 0;
+    for (int i = 0; i < count; ++i) placements += pieces[i];
+}
+
+void BattleRoyale::exportResults() {
+    ResultsExport::Result result{};
+    result.mode = "royale";
+    // bots drop pieces straight down, so t-spin counters are genuinely zero; cheese and
+    // finesse do not apply to them at all
+    result.untracked = 1u << GameHistory::COUNTER_CHEESE;
+    for (int k = GameHistory::COUNTER_FINESSE; k < GameHistory::COUNTER_COUNT; ++k) result.untracked |= 1u << k;
+    result.finishedAt = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    for (int i = 0; i < count; ++i) {
+        // survivors share first place, everyone else ranks behind those who lasted longer
+        int place = 1;
+        for (int j = 0; j < count; ++j) {
+            bool outlasted = eliminatedRound[i] >= 0 && (eliminatedRound[j] < 0 || eliminatedRound[j] > eliminatedRound[i]);
+            if (outlasted) ++place;
+        }
+        result.seed = seeds[i];
+        result.completed = alive[i] != 0;
+        result.place = place; // time stays 0, bots play in rounds rather than against a clock
+        result.counters[GameHistory::COUNTER_PIECES] = pieces[i];
+        result.counters[GameHistory::COUNTER_ATTACK] = linesSent[i];
+        result.counters[GameHistory::COUNTER_LINES] = linesCleared[i];
+        for (int k = 0; k < 4; ++k) result.counters[GameHistory::COUNTER_SINGLE + k] = clearCounts[(size_t)i * 4 + k];
+        result.counters[GameHistory::COUNTER_PC] = perfectClears[i];
+        result.counters[GameHistory::COUNTER_MAX_B2B] = maxB2b[i];
+        result.counters[GameHistory::COUNTER_MAX_COMBO] = maxCombo[i];
+        result.counters[GameHistory::COUNTER_SCORE] = score[i];
+        ResultsExport::write(result);
+    }
+}
+
+void BattleRoyale::runHeadless(double seconds) {
+    auto start = std::chrono::steady_clock::now();
+    double elapsed = 0.0;
+    long long total = 0;
+    int games = 0;
+    int lastWinner = -1;
+
+    while (elapsed < seconds && !stopRequested) {
+        step();
+        if (aliveCount() <= 1) {
+            auto winner = std::find(alive.begin(), alive.end(), 1);
+            lastWinner = winner != alive.end() ? (int)(winner - alive.begin()) : -1;
+            if (ResultsExport::isEnabled()) {
+                exportResults();
+                ResultsExport::flush(); // a finished game is on disk even if the run is killed
+            }
+            total += placements;
+            ++games;
+            reset();
+            placements = 0;
+        }
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    total += placements;
+
+    std::printf("players:            %d\n", count);
+    std::printf("threads:            %d\n", pool.size());
+    std::printf("targeting:          %s\n", config.targeting == Targeting::ATTACKERS ? "attackers" : "random");
+    std::printf("games finished:     %d\n", games);
+    if (lastWinner >= 0) std::printf("last winner:        #%d\n", lastWinner + 1);
+    std::printf("placements:         %lld\n", total);
+    std::printf("elapsed:            %.2f s\n", elapsed);
+    std::printf("placements/second:  %.0f\n", elapsed > 0 ? total / elapsed : 0.0);
+}
+
+void BattleRoyale::spectate(const Settings& settings, float roundsPerSecond) {
+    nodelay(stdscr, TRUE);
+    clear();
+    refresh();
+
+    const auto& pauseKeys = settings.getKeys(Settings::ACTION_PAUSE);
+    const auto& quitKeys = settings.getKeys(Settings::ACTION_QUIT);
+    const auto& restartKeys = settings.getKeys(Settings::ACTION_RESTART);
+
+    auto start = std::chrono::steady_clock::now();
+    auto lastRound = start;
+    double pausedSeconds = 0.0;
+    bool paused = false;
+    auto roundDelay = std::chrono::duration<double>(1.0 / std::max(0.1f, roundsPerSecond));
+
+    while (true) {
+        int ch;
+        while ((ch = getch()) != ERR) {
+            if (quitKeys.contains(ch)) return;
+            if (pauseKeys.contains(ch)) paused = !paused;
+            if (restartKeys.contains(ch)) {
+                reset();
+                placements = 0;
+                start = std::chrono::steady_clock::now();
+                pausedSeconds = 0.0;
+            }
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (paused) {
+            pausedSeconds += std::chrono::duration<double>(now - lastRound).count();
+            lastRound = now;
+        } else if (aliveCount() > 1 && now - lastRound >= roundDelay) {
+            step();
+            lastRound = now;
+        }
+
+        double elapsed = std::chrono::duration<double>(now - start).count() - pausedSeconds;
+        renderSpectator(elapsed, paused);
+        std::this_thread::sleep_for(std::chrono::milliseconds(16)); // ~60 FPS
+    }
+}
+
+void BattleRoyale::renderSpectator(double elapsed, bool paused) {
+    int term_rows, term_cols;
+    getmaxyx(stdscr, term_rows, term_cols);
+    erase();
+
+    int remaining = aliveCount();
+    char header[160];
+    snprintf(header, sizeof(header), "BATTLE ROYALE  Alive: %d/%d  Pieces: %lld  PPS: %.1f%s",
+             remaining, count, placements, elapsed > 0 ? placements / elapsed : 0.0,
+             paused ? "  [PAUSED]" : "");
+    attron(A_BOLD);
+    mvprintw(0, std::max(0, (term_cols - (int)strlen(header)) / 2), "%s", header);
+    attroff(A_BOLD);
+
+    // miniature boards: the 20 visible rows squeezed into 10 by pairing rows
+    const int mini_width = Bitboard::WIDTH + 2;
+    const int mini_height = 10 + 3;
+    int columns = std::max(1, term_cols / (mini_width + 1));
+    int gridRows = std::max(1, (term_rows - 3) / mini_height);
+    int shown = std::min(count, columns * gridRows);
+    int grid_x = std::max(0, (term_cols - columns * (mini_width + 1)) / 2);
+
+    for (int i = 0; i < shown; ++i) {
+        int top = 2 + (i / columns) * mini_height;
+        int left = grid_x + (i % columns) * (mini_width + 1);
+        const uint16_t* board = &rows[(size_t)i * Bitboard::HEIGHT];
+        int attrs = alive[i] ? A_NORMAL : A_DIM;
+
+        attron(attrs);
+        char title[16];
+        if (alive[i]) snprintf(title, sizeof(title), "#%d +%d", i + 1, pendingGarbage[i]);
+        else snprintf(title, sizeof(title), "#%d KO", i + 1);
+        mvprintw(top, left, "%s", title);
+        mvaddch(top + 1, left, ACS_ULCORNER);
+        mvhline(top + 1, left + 1, ACS_HLINE, Bitboard::WIDTH);
+        mvaddch(top + 1, left + mini_width - 1, ACS_URCORNER);
+        for (int y = 0; y < 10; ++y) {
+            uint16_t upper = board[20 + y * 2];
+            uint16_t lower = board[21 + y * 2];
+            mvaddch(top + 2 + y, left, ACS_VLINE);
+            for (int x = 0; x < Bitboard::WIDTH; ++x) {
+                bool a = upper & (1 << x);
+                bool b = lower & (1 << x);
+                char cell = a && b ? '#' : (a ? '"' : (b ? '.' : ' '));
+                mvaddch(top + 2 + y, left + 1 + x, cell);
+            }
+            mvaddch(top + 2 + y, left + mini_width - 1, ACS_VLINE);
+        }
+        mvaddch(top + 12, left, ACS_LLCORNER);
+        mvhline(top + 12, left + 1, ACS_HLINE, Bitboard::WIDTH);
+        mvaddch(top + 12, left + mini_width - 1, ACS_LRCORNER);
+        attroff(attrs);
+    }
+
+    std::string footer;
+    if (remaining <= 1) {
+        auto winner = std::find(alive.begin(), alive.end(), 1);
+        footer = winner != alive.end() ? "Winner: #" + std::to_string(winner - alive.begin() + 1) : "No survivors";
+        footer += "  -  [r] rematch - [q] quit";
+    } else {
+        footer = "[p] pause - [r] restart - [q] quit";
+        if (shown < count) footer += "  (" + std::to_string(count - shown) + " boards hidden)";
+    }
+    attron(A_DIM);
+    mvprintw(term_rows - 1, std::max(0, (term_cols - (int)footer.size()) / 2), "%s", footer.c_str());
+    attroff(A_DIM);
+    refresh();
+}
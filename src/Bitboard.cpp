@@ -0,0 +1,147 @@
+#include <algorithm>
+#include <cstring>
+
+#include "../include/Bitboard.h"
+#include "../include/Tetromino.h"
+
+static const char PIECE_TYPES[] = {'I', 'J', 'L', 'O', 'S', 'Z', 'T'};
+
+static int typeIndex(char type) {
+    for (int i = 0; i < 7; ++i) {
+        if (PIECE_TYPES[i] == type) return i;
+    }
+    return -1;
+}
+
+// row masks for every piece and rotation, built once from the Tetromino shapes
+struct MaskTable {
+    Bitboard::PieceMask masks[7][4] = {};
+    int rotations[7] = {};
+
+    MaskTable() {
+        for (int t = 0; t < 7; ++t) {
+            Tetromino piece(PIECE_TYPES[t]);
+            rotations[t] = piece.getShapesCount();
+            for (int r = 0; r < rotations[t]; ++r) {
+                piece.setRotationState(r);
+                auto shape = piece.getShape();
+                for (int y = 0; y < (int)shape.size() && y < 4; ++y) {
+                    for (int x = 0; x < (int)shape[y].size(); ++x) {
+                        if (shape[y][x]) masks[t][r][y] |= (1 << x);
+                    }
+                }
+            }
+        }
+    }
+};
+
+static const MaskTable& maskTable() {
+    static const MaskTable table;
+    return table;
+}
+
+const Bitboard::PieceMask& Bitboard::getPieceMask(char type, int rotation) {
+    static const PieceMask empty = {};
+    int t = typeIndex(type);
+    if (t < 0) return empty;
+    const auto& table = maskTable();
+    return table.masks[t][rotation % table.rotations[t]];
+}
+
+int Bitboard::getRotationCount(char type) {
+    int t = typeIndex(type);
+    return t < 0 ? 0 : maskTable().rotations[t];
+}
+
+int Bitboard::getSpawnX(char type) {
+    return type == 'O' ? 4 : 3; // matches the Tetromino constructor
+}
+
+Bitboard::Rows Bitboard::fromBoard(const std::vector<std::vector<int>>& board) {
+    Rows rows{};
+    for (int y = 0; y < HEIGHT && y < (int)board.size(); ++y) {
+        uint16_t row = 0;
+        for (int x = 0; x < WIDTH; ++x) {
+            if (board[y][x] != 0) row |= (1 << x);
+        }
+        rows[y] = row;
+    }
+    return rows;
+}
+
+bool Bitboard::fits(const uint16_t* rows, char type, int rotation, int x, int y) {
+    return fits(rows, getPieceMask(type, rotation), x, y);
+}
+
+int Bitboard::dropDistance(const uint16_t* rows, char type, int rotation, int x, int y) {
+    return dropDistance(rows, getPieceMask(type, rotation), x, y);
+}
+
+void Bitboard::place(uint16_t* rows, char type, int rotation, int x, int y) {
+    place(rows, getPieceMask(type, rotation), x, y);
+}
+
+bool Bitboard::fits(const uint16_t* rows, const PieceMask& mask, int x, int y) {
+    if (x < -3) return false;
+    for (int dy = 0; dy < 4; ++dy) {
+        if (!mask[dy]) continue;
+        int by = y + dy;
+        if (by < 0 || by >= HEIGHT) return false;
+        // shift the row left by 3 and fill the padding with walls on both sides
+        uint32_t row = ((uint32_t)rows[by] << 3) | 0x7u | (~0u << (WIDTH + 3));
+        if (row & ((uint32_t)mask[dy] << (x + 3))) return false;
+    }
+    return true;
+}
+
+int Bitboard::dropDistance(const uint16_t* rows, const PieceMask& mask, int x, int y) {
+    int distance = 0;
+    while (fits(rows, mask, x, y + distance + 1)) {
+        ++distance;
+    }
+    return distance;
+}
+
+void Bitboard::place(uint16_t* rows, const PieceMask& mask, int x, int y) {
+    for (int dy = 0; dy < 4; ++dy) {
+        if (!mask[dy]) continue;
+        int by = y + dy;
+        if (by < 0 || by >= HEIGHT) continue;
+        uint32_t bits = x >= 0 ? ((uint32_t)mask[dy] << x) : ((uint32_t)mask[dy] >> -x);
+        rows[by] |= (uint16_t)(bits & FULL_ROW);
+    }
+}
+
+int Bitboard::clearLines(uint16_t* rows) {
+    int write = HEIGHT - 1;
+    for (int read = HEIGHT - 1; read >= 0; --read) {
+        if (rows[read] != FULL_ROW) {
+            rows[write--] = rows[read];
+        }
+    }
+    int cleared = write + 1;
+    std::memset(rows, 0, sizeof(uint16_t) * cleared);
+    return cleared;
+}
+
+bool Bitboard::isEmpty(const uint16_t* rows) {
+    for (int y = 0; y < HEIGHT; ++y) {
+        if (rows[y]) return false;
+    }
+    return true;
+}
+
+bool Bitboard::addGarbage(uint16_t* rows, int lines, int hole) {
+    if (lines <= 0) return true;
+    lines = std::min(lines, HEIGHT);
+    bool overflow = false;
+    for (int y = 0; y < lines; ++y) {
+        if (rows[y]) overflow = true;
+    }
+    std::memmove(rows, rows + lines, sizeof(uint16_t) * (HEIGHT - lines));
+    uint16_t garbage = FULL_ROW & ~(1 << hole);
+    for (int y = HEIGHT - lines; y < HEIGHT; ++y) {
+        rows[y] = garbage;
+    }
+    return !overflow;
+}
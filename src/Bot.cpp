@@ -0,0 +1,85 @@
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+#include "../include/Bot.h"
+#include "../include/Bitboard.h"
+
+Bot::Move Bot::findMove(const uint16_t* rows, char current, char hold, char next) {
+    Move best;
+    double bestScore = -std::numeric_limits<double>::infinity();
+    searchPiece(rows, current, false, best, bestScore);
+    char alternative = hold != 0 ? hold : next;
+    if (alternative != 0 && alternative != current) {
+        searchPiece(rows, alternative, true, best, bestScore);
+    }
+    return best;
+}
+
+void Bot::searchPiece(const uint16_t* rows, char type, bool useHold, Move& best, double& bestScore) {
+    int spawnX = Bitboard::getSpawnX(type);
+    int spawnY = 20;
+    int rotations = Bitboard::getRotationCount(type);
+    Bitboard::Rows after;
+
+    for (int r = 0; r < rotations; ++r) {
+        const auto& mask = Bitboard::getPieceMask(type, r);
+        // rotations are applied at spawn, where the unkicked SRS test is the first one tried
+        if (!Bitboard::fits(rows, mask, spawnX, spawnY)) continue;
+        for (int targetX = -3; targetX < Bitboard::WIDTH; ++targetX) {
+            int x = spawnX;
+            int step = targetX > x ? 1 : -1;
+            bool reachable = true;
+            while (x != targetX) {
+                if (!Bitboard::fits(rows, mask, x + step, spawnY)) {
+                    reachable = false;
+                    break;
+                }
+                x += step;
+            }
+            if (!reachable) continue;
+
+            int y = spawnY + Bitboard::dropDistance(rows, mask, x, spawnY);
+            std::memcpy(after.data(), rows, sizeof(uint16_t) * Bitboard::HEIGHT);
+            Bitboard::place(after.data(), mask, x, y);
+            int lines = Bitboard::clearLines(after.data());
+
+            double score = evaluate(after.data(), lines);
+            if (score > bestScore) {
+                bestScore = score;
+                best.valid = true;
+                best.useHold = useHold;
+                best.rotation = r;
+                best.x = targetX;
+            }
+        }
+    }
+}
+
+double Bot::evaluate(const uint16_t* rows, int linesCleared) {
+    // aggregate height, lines, holes and bumpiness weighted like the classic tuned heuristic
+    int heights[Bitboard::WIDTH] = {};
+    int holes = 0;
+    uint16_t covered = 0;
+    for (int y = 0; y < Bitboard::HEIGHT; ++y) {
+        uint16_t row = rows[y];
+        holes += __builtin_popcount(covered & ~row & Bitboard::FULL_ROW);
+        uint16_t fresh = row & ~covered;
+        for (int x = 0; fresh; ++x, fresh >>= 1) {
+            if (fresh & 1) heights[x] = Bitboard::HEIGHT - y;
+        }
+        covered |= row;
+    }
+
+    int aggregateHeight = 0;
+    int bumpiness = 0;
+    for (int x = 0; x < Bitboard::WIDTH; ++x) {
+        aggregateHeight += heights[x];
+        if (x > 0) bumpiness += std::abs(heights[x] - heights[x - 1]);
+    }
+
+    return -0.510066 * aggregateHeight
+         + 0.760666 * linesCleared
+         - 0.35663 * holes
+         - 0.184483 * bumpiness;
+}
@@ -0,0 +1,82 @@
+#include <poll.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
+#include "../include/ConfigWatcher.h"
+#include "../include/Trace.h"
+
+std::thread ConfigWatcher::watcher;
+std::atomic<bool> ConfigWatcher::running{false};
+std::atomic<SettingsStore::Data*> ConfigWatcher::pending{nullptr};
+std::string ConfigWatcher::watchedPath;
+
+static const int IDLE_POLL_MS = 100; // how often the thread wakes to check for stop
+
+void ConfigWatcher::start(const std::string& path) {
+#ifdef __linux__
+    if (running) return;
+    watchedPath = path;
+    running = true;
+    watcher = std::thread(watchLoop);
+#else
+    (void)path; // no inotify, settings only change through the settings screen
+#endif
+}
+
+void ConfigWatcher::stop() {
+    if (!running) return;
+    running = false;
+    if (watcher.joinable()) watcher.join();
+    delete pending.exchange(nullptr);
+}
+
+std::unique_ptr<SettingsStore::Data> ConfigWatcher::take() {
+    // whoever exchanges a snapshot out owns it, so neither side can free one the other still reads
+    return std::unique_ptr<SettingsStore::Data>(pending.exchange(nullptr, std::memory_order_acquire));
+}
+
+void ConfigWatcher::watchLoop() {
+#ifdef __linux__
+    Trace::registerThread("config");
+    size_t slash = watchedPath.find_last_of('/');
+    std::string dir = slash == std::string::npos ? "." : watchedPath.substr(0, slash + 1);
+    std::string name = slash == std::string::npos ? watchedPath : watchedPath.substr(slash + 1);
+
+    // saves replace the file by rename, so watch the directory rather than the inode
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) return;
+    if (inotify_add_watch(fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        close(fd);
+        return;
+    }
+
+    alignas(struct inotify_event) char buffer[4096];
+    while (running.load(std::memory_order_relaxed)) {
+        struct pollfd pfd = {fd, POLLIN, 0};
+        if (poll(&pfd, 1, IDLE_POLL_MS) <= 0) continue;
+
+        bool changed = false;
+        ssize_t n;
+        while ((n = read(fd, buffer, sizeof(buffer))) > 0) {
+            for (char* p = buffer; p < buffer + n;) {
+                auto* event = reinterpret_cast<struct inotify_event*>(p);
+                if (event->len > 0 && name == event->name) changed = true;
+                p += sizeof(struct inotify_event) + event->len;
+            }
+        }
+        if (!changed) continue;
+
+        // half-written or foreign files fail the checksum and are ignored
+        auto* fresh = new SettingsStore::Data;
+        if (!SettingsStore::load(watchedPath, *fresh)) {
+            delete fresh;
+            continue;
+        }
+        delete pending.exchange(fresh, std::memory_order_acq_rel);
+    }
+    close(fd);
+#endif
+}
@@ -0,0 +1,145 @@
+#include <array>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <tuple>
+#include <vector>
+
+#include "../include/Finesse.h"
+#include "../include/Bitboard.h"
+#include "../include/GameUtils.h"
+#include "../include/Tetromino.h"
+
+static const char PIECE_TYPES[] = {'I', 'J', 'L', 'O', 'S', 'Z', 'T'};
+
+static int typeIndex(char type) {
+    for (int i = 0; i < 7; ++i) {
+        if (PIECE_TYPES[i] == type) return i;
+    }
+    return -1;
+}
+
+// breadth-first search over (rotation, x, y) from spawn using the real movement and SRS code
+struct FinesseTable {
+    int8_t inputs[7][4][13];
+
+    FinesseTable() {
+        std::memset(inputs, -1, sizeof(inputs));
+        const std::vector<std::vector<int>> board(Bitboard::HEIGHT, std::vector<int>(Bitboard::WIDTH, 0));
+        for (int t = 0; t < 7; ++t) {
+            search(PIECE_TYPES[t], board, inputs[t]);
+        }
+    }
+
+    static void search(char type, const std::vector<std::vector<int>>& board, int8_t (&best)[4][13]) {
+        using State = std::tuple<int, int, int>; // rotation, x, y
+        std::map<State, int> cost;
+        std::deque<Tetromino> frontier;
+
+        auto visit = [&](const Tetromino& piece, int steps) {
+            State state{piece.getRotationState(), piece.getX(), piece.getY()};
+            if (cost.count(state)) return;
+            cost[state] = steps;
+            frontier.push_back(piece);
+        };
+
+        visit(Tetromino(type), 0);
+        while (!frontier.empty()) {
+            Tetromino piece = frontier.front();
+            frontier.pop_front();
+            int steps = cost[{piece.getRotationState(), piece.getX(), piece.getY()}] + 1;
+
+            for (int dir : {-1, 1}) {
+                Tetromino moved = piece;
+                moved.setX(piece.getX() + dir);
+                if (!GameUtils::canPlace(moved, board)) continue;
+                visit(moved, steps); // tap
+                Tetromino wall = moved;
+                while (true) {
+                    Tetromino next = wall;
+                    next.setX(wall.getX() + dir);
+                    if (!GameUtils::canPlace(next, board)) break;
+                    wall = next;
+                }
+                visit(wall, steps); // das to the wall
+            }
+            Tetromino cw = piece, ccw = piece, flip = piece;
+            cw.rotateCW(board);
+            ccw.rotateCCW(board);
+            flip.rotate180(board);
+            visit(cw, steps);
+            visit(ccw, steps);
+            visit(flip, steps);
+        }
+
+        // fewest inputs per final pose, ignoring height
+        int poseCost[4][13];
+        for (auto& row : poseCost) for (int& c : row) c = -1;
+        for (const auto& [state, steps] : cost) {
+            auto [rotation, x, y] = state;
+            int column = x + 3;
+            if (column < 0 || column >= 13) continue;
+            int& c = poseCost[rotation][column];
+            if (c < 0 || steps < c) c = steps;
+        }
+
+        // poses that drop into the same cells are the same placement (S/Z/I orientations, O)
+        std::array<Bitboard::Rows, 4 * 13> footprints{};
+        Bitboard::Rows emptyRows{};
+        for (int r = 0; r < 4; ++r) {
+            for (int column = 0; column < 13; ++column) {
+                if (poseCost[r][column] < 0) continue;
+                int x = column - 3;
+                auto& rows = footprints[r * 13 + column];
+                rows = emptyRows;
+                int drop = Bitboard::dropDistance(emptyRows.data(), type, r, x, 20);
+                Bitboard::place(rows.data(), type, r, x, 20 + drop);
+            }
+        }
+        for (int r = 0; r < 4; ++r) {
+            for (int column = 0; column < 13; ++column) {
+                if (poseCost[r][column] < 0) continue;
+                int minimum = poseCost[r][column];
+                for (int other = 0; other < 4 * 13; ++other) {
+                    int oc = poseCost[other / 13][other % 13];
+                    if (oc >= 0 && oc < minimum && footprints[other] == footprints[r * 13 + column]) {
+                        minimum = oc;
+                    }
+                }
+                best[r][column] = (int8_t)minimum;
+            }
+        }
+    }
+};
+
+static const FinesseTable& finesseTable() {
+    static const FinesseTable table;
+    return table;
+}
+
+void Finesse::init() {
+    finesseTable();
+}
+
+int Finesse::optimalInputs(char type, int rotation, int x) {
+    int t = typeIndex(type);
+    int column = x - MIN_X;
+    if (t < 0 || rotation < 0 || rotation >= 4 || column < 0 || column >= COLUMNS) return -1;
+    return finesseTable().inputs[t][rotation][column];
+}
+
+int Finesse::countInputs(const char* log, int length) {
+    int count = 0;
+    for (int i = 0; i < length; ++i) {
+        char c = log[i];
+        if (c == 'L' || c == 'R' || c == 'C' || c == 'W' || c == 'F') count++;
+    }
+    return count;
+}
+
+bool Finesse::isJudgeable(const char* log, int length) {
+    for (int i = 0; i < length; ++i) {
+        if (log[i] == 'D') return false;
+    }
+    return true;
+}
@@ -2,11 +2,16 @@
 #include <thread>
 #include <atomic>
 #include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
 #include <ctime>
 #include <fstream>
 #include <queue>
 #include <iomanip>
 #include <algorithm>
+#include <iterator>
+#include <cstdlib>
 
 #include "../include/Game.h"
 #include "../include/GameUtils.h"
@@ -14,12 +19,46 @@
 #include "../include/Settings.h"
 #include "../include/Tetromino.h"
 #include "../include/SRS.h"
+#include "../include/Bitboard.h"
+#include "../include/Bot.h"
+#include "../include/Profiler.h"
+#include "../include/Trace.h"
+#include "../include/Telemetry.h"
+#include "../include/Finesse.h"
+#include "../include/OutputMonitor.h"
+#include "../include/GameHistory.h"
+#include "../include/ResultsExport.h"
+
+// single-player modes a game can be suspended in, as set from the menu
+static bool suspendableMode(const std::string& mode) {
+    static const char* modes[] = {
+        "sprint_20l", "sprint_40l", "sprint_100l", "blitz_1min", "blitz_2min", "blitz_4min", "zen",
+        "cheese_10l", "cheese_18l", "cheese_100l", "finesse", "practice", "marathon", "master"
+    };
+    return std::find(std::begin(modes), std::end(modes), mode) != std::end(modes);
+}
+
+static bool pieceLetter(char type) {
+    return type != 0 && std::strchr("IOTJLSZ", type) != nullptr;
+}
+
+// lines to clear in a sprint mode, 0 for any other mode
+static int sprintTarget(const std::string& mode) {
+    if (mode == "sprint_20l") return 20;
+    if (mode == "sprint_40l") return 40;
+    if (mode == "sprint_100l") return 100;
+    return 0;
+}
 
 void Game::reset() {
     board.assign(40, std::vector<int>(10, 0));
     bag.clear();
-    auto bag1 = GameUtils::generateBag();
-    auto bag2 = GameUtils::generateBag();
+    // one seeded generator per game, so a suspended game can replay it to the same state
+    rngSeed = std::random_device{}();
+    rng.seed(rngSeed);
+    bagsDealt = 2;
+    auto bag1 = GameUtils::generateBag(rng);
+    auto bag2 = GameUtils::generateBag(rng);
     bag.reserve(bag1.size() + bag2.size());
     bag.insert(bag.end(), bag1.begin(), bag1.end());
     bag.insert(bag.end(), bag2.begin(), bag2.end());
@@ -50,293 +89,1107 @@ void Game::reset() {
     };
     cheeseCount = 0;
     cheeseGenerated = 9;
-    lastFallTime = std::chrono::steady_clock::now();
-    gameStart = std::chrono::steady_clock::now();
+    simClock = std::chrono::steady_clock::now();
+    fallProgress = 0.0;
+    gameStart = simClock;
     totalPausedDuration = 0.0;
+    pieceSpawnTime = simClock;
+    gameId = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    clearPieceInputs();
+    rolling.clear();
+    splitCount = 0;
+    paceKnown = false;
+    pbSplitCount = 0;
+    pbTime = 0.0;
+    if (const Leaderboard::Run* best = Leaderboard::personalBest(Settings::getMode())) {
+        pbSplitCount = (int)best->splitCount;
+        std::copy(best->splits, best->splits + pbSplitCount, pbSplits.begin());
+        pbTime = best->time;
+    }
+    incomingGarbage.clear();
+    outgoingAttack = 0;
+    restartPressed = false;
+    toppedOut = false;
+    lockDelayActive = false;
+    spawnPending = false;
+    bufferedRotation = 0;
+    bufferedHold = false;
+    popupLines.clear();
+    relayoutRequested = true; // mode and label may differ from the last game
+    dirty = DIRTY_ALL;
+    invalidate();
     if (Settings::getMode().find("cheese_") == 0) {
         GameUtils::generateCheeseLines(board, 9);
     }
+    boardRowsStale = true;
+    practiceMode = Settings::getMode() == "practice";
+    applyLevel();
+    history.clear();
+    if (practiceMode) history.push(packState());
 }
 
-void Game::newPiece() {
-    currentPiece = bag.front();
+// statistics captured by practice snapshots, in PracticeHistory::State::stats order
+static const char* practiceStats[PracticeHistory::STAT_COUNT] = {
+    "totalPieces", "attack", "lines", "single", "double", "triple", "tetris", "tspins", "tss", "tsd",
+    "tst", "tspin_minis", "pc", "b2bStreak", "max_b2bStreak", "combo", "max_combo", "score", "cheeseCleared"
+};
+
+PracticeHistory::State Game::packState() {
+    PracticeHistory::State state{};
+    for (int y = 0; y < Bitboard::HEIGHT; ++y) {
+        for (int x = 0; x < Bitboard::WIDTH; ++x) {
+            int cell = y * Bitboard::WIDTH + x;
+            state.cells[cell / 2] |= (board[y][x] & 0xF) << ((cell & 1) * 4);
+        }
+    }
+    state.current = currentPiece.getType();
+    state.held = holdPiece.getType();
+    state.holdAvailable = holdAvailable;
+    state.queueLength = std::min<size_t>(bag.size(), PracticeHistory::QUEUE_LENGTH);
+    for (int i = 0; i < state.queueLength; ++i) state.queue[i] = bag[i].getType();
+    for (int i = 0; i < PracticeHistory::STAT_COUNT; ++i) state.stats[i] = statistics[practiceStats[i]];
+    state.bagsDealt = bagsDealt;
+    return state;
+}
+
+void Game::restoreState(const PracticeHistory::State& state) {
+    for (int y = 0; y < Bitboard::HEIGHT; ++y) {
+        for (int x = 0; x < Bitboard::WIDTH; ++x) {
+            int cell = y * Bitboard::WIDTH + x;
+            board[y][x] = (state.cells[cell / 2] >> ((cell & 1) * 4)) & 0xF;
+        }
+    }
+    currentPiece = Tetromino(state.current);
+    holdPiece = Tetromino(state.held);
+    holdAvailable = state.holdAvailable;
+    bag.clear();
+    for (int i = 0; i < state.queueLength; ++i) bag.emplace_back(state.queue[i]);
+    for (int i = 0; i < PracticeHistory::STAT_COUNT; ++i) statistics[practiceStats[i]] = state.stats[i];
+    // the generator goes back with the queue, so a placement made again deals the same pieces
+    rng.seed(rngSeed);
+    for (bagsDealt = 0; bagsDealt < state.bagsDealt; ++bagsDealt) GameUtils::generateBag(rng);
+    boardRowsStale = true;
+    lastRotation = 0;
+    lockDelayActive = false;
+    spawnPending = false;
+    bufferedRotation = 0;
+    bufferedHold = false;
+    clearPieceInputs();
+    pieceSpawnTime = simClock;
+    dirty |= DIRTY_BOARD | DIRTY_HOLD | DIRTY_NEXT | DIRTY_STATS;
+}
+
+void Game::recordPlacement() {
+    if (practiceMode && isRunning) history.push(packState());
+}
+
+std::chrono::steady_clock::duration Game::tickDuration = std::chrono::milliseconds(1);
+
+void Game::setTickRate(int hz) {
+    hz = std::max(60, std::min(hz, 10000));
+    tickDuration = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / hz));
+}
+
+int Game::getTickRate() {
+    return (int)std::lround(1.0 / std::chrono::duration<double>(tickDuration).count());
+}
+
+volatile std::sig_atomic_t Game::suspendable = 0;
+volatile std::sig_atomic_t Game::suspendRequested = 0;
+
+static const uint32_t SUSPEND_MAGIC = 0x47544c43; // "CLTG"
+static const uint32_t SUSPEND_VERSION = 3; // 1 had no sprint splits, 2 kept bags dealt outside the snapshot
+
+std::string Game::suspendPath() {
+    return Settings::getUserDataPath() + "suspended.bin";
+}
+
+bool Game::requestSuspend() {
+    if (!suspendable) return false;
+    suspendRequested = 1;
+    return true;
+}
+
+// the suspend blob is a flat record in host byte order with a crc32 trailer, like the settings
+// store; structs such as PracticeHistory::State are copied as laid out in memory, padding included
+template <typename T>
+static void put(std::string& out, const T& value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+static bool take(const std::string& in, size_t& pos, T& value) {
+    if (pos + sizeof(value) > in.size()) return false;
+    std::memcpy(&value, in.data() + pos, sizeof(value));
+    pos += sizeof(value);
+    return true;
+}
+
+bool Game::suspend(const std::string& path) {
+    if (spawnPending) spawnPiece(); // the file only knows a piece in play
+    PracticeHistory::State state = packState();
+    std::string blob;
+    blob.reserve(512);
+    put(blob, SUSPEND_MAGIC);
+    put(blob, SUSPEND_VERSION);
+    std::string mode = Settings::getMode();
+    put(blob, (uint8_t)mode.size());
+    blob += mode;
+    put(blob, rngSeed);
+    put(blob, state); // board, hold, queue, the fixed statistics and bags dealt
+    put(blob, (int8_t)currentPiece.getX());
+    put(blob, (int8_t)currentPiece.getY());
+    put(blob, (int8_t)currentPiece.getRotationState());
+    uint32_t lockElapsedMs = lockDelayActive
+        ? (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(simClock - lockStartTime).count()
+        : 0;
+    put(blob, (uint8_t)lockDelayActive);
+    put(blob, lockElapsedMs);
+    put(blob, gameTime); // already excludes paused time
+    put(blob, (int32_t)cheeseCount);
+    put(blob, (int32_t)cheeseGenerated);
+    put(blob, (uint8_t)splitCount);
+    put(blob, splits);
+    // mode specific statistics (finesse) are only known by name
+    put(blob, (uint16_t)statistics.size());
+    for (const auto& [name, value] : statistics) {
+        put(blob, (uint8_t)name.size());
+        blob += name;
+        put(blob, (int32_t)value);
+    }
+    put(blob, SettingsStore::crc32(blob.data(), blob.size()));
+
+    std::string temp = path + ".tmp";
+    std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+    if (!file) return false;
+    file.write(blob.data(), blob.size());
+    file.close();
+    if (!file || std::rename(temp.c_str(), path.c_str()) != 0) {
+        std::remove(temp.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool Game::resume(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    std::string blob((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    file.close();
+    if (!restore(blob)) {
+        std::remove(path.c_str()); // a damaged save must not be offered again
+        return false;
+    }
+    return true;
+}
+
+bool Game::restore(std::string& blob) {
+    uint32_t checksum = 0;
+    if (blob.size() < sizeof(checksum)) return false;
+    std::memcpy(&checksum, blob.data() + blob.size() - sizeof(checksum), sizeof(checksum));
+    blob.resize(blob.size() - sizeof(checksum));
+    if (checksum != SettingsStore::crc32(blob.data(), blob.size())) return false;
+
+    size_t pos = 0;
+    uint32_t magic = 0, version = 0, seed = 0, lockElapsedMs = 0;
+    uint8_t modeLength = 0, lockActive = 0, splitsTaken = 0;
+    int8_t x = 0, y = 0, rotation = 0;
+    int32_t cheese = 0, generated = 0;
+    uint16_t statCount = 0;
+    double elapsed = 0.0;
+    PracticeHistory::State state;
+    std::array<double, Leaderboard::MAX_SPLITS> splitTimes{};
+    if (!take(blob, pos, magic) || magic != SUSPEND_MAGIC) return false;
+    if (!take(blob, pos, version) || version != SUSPEND_VERSION) return false;
+    if (!take(blob, pos, modeLength) || pos + modeLength > blob.size()) return false;
+    std::string mode = blob.substr(pos, modeLength);
+    pos += modeLength;
+    if (!take(blob, pos, seed) || !take(blob, pos, state) ||
+        !take(blob, pos, x) || !take(blob, pos, y) || !take(blob, pos, rotation) ||
+        !take(blob, pos, lockActive) || !take(blob, pos, lockElapsedMs) || !take(blob, pos, elapsed) ||
+        !take(blob, pos, cheese) || !take(blob, pos, generated) || !take(blob, pos, splitsTaken) || !take(blob, pos, splitTimes) ||
+        !take(blob, pos, statCount)) {
+        return false;
+    }
+    std::unordered_map<std::string, int> stats;
+    for (int i = 0; i < statCount; ++i) {
+        uint8_t nameLength = 0;
+        int32_t value = 0;
+        if (!take(blob, pos, nameLength) || pos + nameLength > blob.size()) return false;
+        std::string name = blob.substr(pos, nameLength);
+        pos += nameLength;
+        if (!take(blob, pos, value)) return false;
+        stats[name] = value;
+    }
+    if (pos != blob.size() || state.queueLength > PracticeHistory::QUEUE_LENGTH ||
+        splitsTaken > Leaderboard::MAX_SPLITS) {
+        return false;
+    }
+
+    // the checksum only catches damage, so everything the game indexes or loops on is checked
+    // here, before any of it is applied
+    if (!suspendableMode(mode) || !pieceLetter(state.current) || (state.held != 0 && !pieceLetter(state.held))) {
+        return false;
+    }
+    for (int i = 0; i < state.queueLength; ++i) {
+        if (!pieceLetter(state.queue[i])) return false;
+    }
+    Tetromino placed(state.current);
+    if (rotation < 0 || rotation >= placed.getShapesCount()) return false;
+    placed.setX(x);
+    placed.setY(y);
+    placed.setRotationState(rotation);
+    if (!GameUtils::canPlace(placed, std::vector<std::vector<int>>(40, std::vector<int>(10, 0)))) return false;
+    // a bag is dealt every seven pieces, beyond that the replay below would never end
+    int32_t pieces = state.stats[0]; // totalPieces
+    if (pieces < 0 || state.bagsDealt > 3 + (uint32_t)pieces / 7) return false;
+    if (!(elapsed >= 0.0)) return false;
+
+    Settings::setMode(mode);
+    init();
+    statistics = stats;
+    // replaying the shuffles puts the generator exactly where the suspended game left it
+    rngSeed = seed;
+    restoreState(state);
+    currentPiece.setX(x);
+    currentPiece.setY(y);
+    currentPiece.setRotationState(rotation);
+
+    auto now = std::chrono::steady_clock::now();
+    simClock = now;
+    lockDelayActive = lockActive != 0;
+    lockStartTime = now - std::chrono::milliseconds(lockElapsedMs);
+    gameTime = elapsed;
+    gameStart = now - std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(elapsed));
+    totalPausedDuration = 0.0;
+    fallProgress = 0.0;
+    cheeseCount = cheese;
+    cheeseGenerated = generated;
+    // the splits carry over, so a resumed sprint is ranked like any other
+    splits = splitTimes;
+    splitCount = splitsTaken;
+    if (splitCount > 0 && splitCount <= pbSplitCount) {
+        paceDelta = splits[splitCount - 1] - pbSplits[splitCount - 1];
+        paceKnown = true;
+    }
+    applyLevel();
+    history.clear();
+    if (practiceMode) history.push(packState());
+    return true;
+}
+
+Tetromino Game::dealPiece() {
+    Tetromino piece = bag.front();
     bag.erase(bag.begin());
     if (bag.size() <= 7) {
-        auto newBag = GameUtils::generateBag();
+        auto newBag = GameUtils::generateBag(rng);
+        bagsDealt++;
         bag.insert(bag.end(), newBag.begin(), newBag.end());
     }
+    return piece;
+}
+
+void Game::newPiece() {
+    currentPiece = dealPiece();
     statistics["totalPieces"]++;
+    pieceSpawnTime = simClock;
+    clearPieceInputs();
+    dirty |= DIRTY_BOARD | DIRTY_NEXT | DIRTY_STATS;
 
     if (!GameUtils::canPlace(currentPiece, board)) {
+        Trace::instant("topout");
+        toppedOut = true;
         isRunning = false;
+    } else {
+        settle();
+    }
+}
+
+void Game::scheduleSpawn(int lines) {
+    float delay = areMs + (lines > 0 ? lineClearMs : 0.0f);
+    if (delay <= 0.0f) {
+        newPiece();
+        return;
     }
+    spawnPending = true;
+    spawnAt = simClock + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double, std::milli>(delay));
+    dirty |= DIRTY_BOARD;
+}
+
+void Game::spawnPiece() {
+    spawnPending = false;
+    bool initialHold = bufferedHold && holdAvailable;
+    int rotation = bufferedRotation;
+    bufferedHold = false;
+    bufferedRotation = 0;
+
+    currentPiece = dealPiece();
+    statistics["totalPieces"]++;
+    pieceSpawnTime = simClock;
+    clearPieceInputs();
+    lastRotation = 0;
+    dirty |= DIRTY_BOARD | DIRTY_NEXT | DIRTY_STATS;
+
+    // IHS: the piece that would have spawned goes straight to hold, like a hold on its first tick
+    if (initialHold) {
+        Tetromino incoming = currentPiece;
+        if (holdPiece.getType() != 0) {
+            currentPiece = holdPiece;
+        } else {
+            currentPiece = dealPiece();
+            statistics["totalPieces"]++;
+        }
+        holdPiece = incoming;
+        holdAvailable = false;
+        noteInput('H');
+        dirty |= DIRTY_HOLD;
+    }
+
+    // IRS: spawn already rotated when that fits, otherwise in spawn orientation; pieces with
+    // fewer shapes (the O has one) wrap around, so nothing indexes past their shape table
+    rotation %= currentPiece.getShapesCount();
+    if (rotation != 0) {
+        Tetromino rotated = currentPiece;
+        rotated.setRotationState(rotation);
+        if (GameUtils::canPlace(rotated, board)) {
+            currentPiece = rotated;
+            noteInput(rotation == 1 ? 'C' : rotation == 2 ? 'F' : 'W');
+            lastRotation = 1;
+        }
+    }
+
+    if (!GameUtils::canPlace(currentPiece, board)) {
+        Trace::instant("topout");
+        toppedOut = true;
+        isRunning = false;
+    } else {
+        settle();
+    }
+}
+
+void Game::applyLevel() {
+    const std::string mode = Settings::getMode();
+    int level = GameUtils::levelForLines(statistics["lines"]);
+    if (mode == "marathon") {
+        gravity = GameUtils::levelGravity(level);
+        lockDelayMs = 500;
+    } else if (mode == "master") {
+        // 20g from the first piece, lock delay shrinks from 500 ms to 150 ms by level 15
+        gravity = GameUtils::INSTANT_GRAVITY;
+        lockDelayMs = std::max(150, 500 - 25 * (level - 1));
+    } else {
+        gravity = 1.0 / 500;
+        lockDelayMs = 500;
+    }
+}
+
+void Game::settle() {
+    // at 20g a piece never hangs in the air, not even between two moves of the same tick;
+    // dropping a row restarts lock delay, so sliding over holes still gives time to react
+    if (practiceMode || gravity < GameUtils::INSTANT_GRAVITY) return;
+    int fall = dropDistance();
+    if (fall > 0) {
+        currentPiece.setY(currentPiece.getY() + fall);
+        lockDelayActive = false;
+        dirty |= DIRTY_BOARD;
+    }
+}
+
+int Game::dropDistance() {
+    if (boardRowsStale) {
+        boardRows = Bitboard::fromBoard(board);
+        boardRowsStale = false;
+    }
+    return Bitboard::dropDistance(boardRows.data(), currentPiece.getType(), currentPiece.getRotationState(),
+                                  currentPiece.getX(), currentPiece.getY());
 }
 
 Game::Game()
     : isRunning(false),
       board(40, std::vector<int>(10, 0)),
-      fallDelay(500),
       gameStart(std::chrono::steady_clock::now()) {}
 
+Game::~Game() {
+    stopRenderer();
+    releaseWindows();
+}
+
 void Game::init() {
     isRunning = true;
     quitPressed = false;
+    endPressed = false;
+    isPaused = false;
     reset();
     erase();
     refresh();
 }
 
-void Game::run(const Settings& settings) {
-    nodelay(stdscr, TRUE);
+void Game::applySettings(const Settings& settings) {
+    arr = settings.getARR();
+    das = settings.getDAS();
+    dcd = settings.getDCD();
+    sdf = settings.getSDF();
+    // practice places pieces one by one, waiting between them only gets in the way
+    areMs = practiceMode ? 0.0f : settings.getARE();
+    lineClearMs = practiceMode ? 0.0f : settings.getLineClearDelay();
+
+    holdEstimation = settings.getHoldEstimation();
+    heldWindow = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double, std::milli>(settings.getRepeatInterval()) + PUBLISH_INTERVAL);
+    holdEstimator.configure(settings.getRepeatDelay(), settings.getRepeatInterval());
+    holdEstimator.untrackAll();
+    for (Settings::Action action : {Settings::ACTION_LEFT, Settings::ACTION_RIGHT}) {
+        for (int key : settings.getKeys(action)) holdEstimator.track(key);
+    }
+    settingsGeneration = Settings::generation();
+}
 
-    float arr = settings.getARR(); // auto repeat rate (ms)
-    float das = settings.getDAS(); // delayed auto shift (ms)
-    float dcd = settings.getDCD(); // das cut delay (ms)
-    float sdf = settings.getSDF(); // soft drop factor (ms)
+void Game::start(const Settings& settings) {
+    Settings::reload();
+    applySettings(settings);
+    holdEstimator.reset();
 
     leftHeld = false;
     rightHeld = false;
     softDropHeld = false;
     lastDirection = 0;
+    leftInitial = true;
+    rightInitial = true;
+    leftDCD = false;
+    rightDCD = false;
 
-    auto lastLeft = std::chrono::steady_clock::now();
-    auto lastRight = std::chrono::steady_clock::now();
-    auto lastSoftDrop = std::chrono::steady_clock::now();
-    bool leftInitial = true, rightInitial = true;
-    bool leftDCD = false, rightDCD = false;
-    std::unordered_set<int> heldKeys;
+    simClock = std::chrono::steady_clock::now();
+    lastLeft = simClock;
+    lastRight = simClock;
+    lastSoftDrop = simClock;
+    leftSeen = simClock;
+    rightSeen = simClock;
+    softDropSeen = simClock;
+}
+
+void Game::run(const Settings& settings) {
+    nodelay(stdscr, TRUE);
+    start(settings);
+
+    InputReader::start();
+    suspendable = !botControlled;
+    startRenderer();
+    std::vector<InputEvent> input;
     while (isRunning) {
-        const auto& keyBindings = settings.getKeyBindings();
+        if (suspendRequested) {
+            quitPressed = true;
+            isRunning = false;
+            break;
+        }
         if (isPaused) {
-            auto pauseStartTime = std::chrono::steady_clock::now();
-            UI::showPauseScreen();
-            int pause_ch;
-            while (isPaused) {
-                pause_ch = getch();
-                const auto& pauseKeys = keyBindings.at("PAUSE");
-                const auto& quitKeys = keyBindings.at("QUIT");
-                if (std::find(pauseKeys.begin(), pauseKeys.end(), pause_ch) != pauseKeys.end()) {
-                    isPaused = false;
-                } else if (std::find(quitKeys.begin(), quitKeys.end(), pause_ch) != quitKeys.end()) {
-                    quitPressed = true;
-                    isRunning = false;
-                    break;
-                }
-            }
-            auto pauseEndTime = std::chrono::steady_clock::now();
-            totalPausedDuration += std::chrono::duration<double>(pauseEndTime - pauseStartTime).count();
-            clear();
-            refresh();
+            // the pause screen is drawn here, so the terminal goes back to this thread meanwhile
+            stopRenderer();
+            waitWhilePaused(settings);
+            startRenderer();
             continue;
         }
 
-        int ch;
-        bool sawLeft = false, sawRight = false, sawSoftDrop = false;
-        while ((ch = getch()) != ERR) {
-            for (const auto& [action, keys] : keyBindings) {
-                for (int key : keys) {
-                    if (ch == key) {
-                        if (action == "LEFT") {
-                            if (!leftHeld) {
-                                // from neutral, use DAS
-                                leftInitial = true;
-                                leftDCD = false;
-                            } else if (lastDirection != -1) {
-                                // switching direction, use DCD
-                                leftDCD = true;
-                                leftInitial = false;
-                            }
-                            leftHeld = true;
-                            sawLeft = true;
-                            lastDirection = -1;
-                        } else if (action == "RIGHT") {
-                            if (!rightHeld) {
-                                rightInitial = true;
-                                rightDCD = false;
-                            } else if (lastDirection != 1) {
-                                rightDCD = true;
-                                rightInitial = false;
-                            }
-                            rightHeld = true;
-                            sawRight = true;
-                            lastDirection = 1;
-                        } else if (action == "SOFT_DROP") {
-                            softDropHeld = true;
-                            sawSoftDrop = true;
-                        } else {
-                            handleInput(settings, ch);
-                        }
-                    }
-                }
+        input.clear();
+        {
+            Trace::Span span("poll input");
+            InputReader::drain(input);
+        }
+
+        step(settings, input);
+        if (Profiler::isEnabled()) {
+            for (const auto& event : input) {
+                if (event.type == InputEvent::PRESS) Profiler::inputApplied(event.time);
             }
         }
+        // drawing happens on the render thread; a key cuts the wait short so it is applied at once
+        InputReader::waitForInput(simClock + tickDuration);
+    }
+    stopRenderer();
+    InputReader::stop();
+    suspendable = 0;
 
-        if (!sawLeft) { leftHeld = false; leftInitial = true; leftDCD = false; }
-        if (!sawRight) { rightHeld = false; rightInitial = true; rightDCD = false; }
-        if (!sawSoftDrop) { softDropHeld = false; }
-        
-        auto now = std::chrono::steady_clock::now();
-        auto leftDuration = std::chrono::duration_cast<std::chrono::milliseconds>(now - lastLeft).count();
-        auto rightDuration = std::chrono::duration_cast<std::chrono::milliseconds>(now - lastRight).count();
-        auto softDropDuration = std::chrono::duration_cast<std::chrono::milliseconds>(now - lastSoftDrop).count();
-
-        // std::string softDropStr = "SoftDrop: " + std::to_string(softDropDuration) + " ms";
-        // int log_y = LINES - 2;
-        // int log_x = 1;
-        // mvprintw(log_y, log_x, "%s", softDropStr.c_str());
-
-        if (leftHeld && (!rightHeld || lastDirection == -1)) {
-            float delay = leftInitial ? das : (leftDCD ? dcd : arr);
-            if (leftInitial || leftDCD || leftDuration >= delay) { // only using leftInitial and leftDCD
-                Tetromino moved = currentPiece;
-                moved.moveLeft();
-                if (GameUtils::canPlace(moved, board)) {
-                    currentPiece.moveLeft();
-                    lastLeft = now;
-                }
-                if (leftInitial) leftInitial = false;
-                if (leftDCD) leftDCD = false;
+    // a quit mid-game keeps the game for the next launch instead of discarding it, unless the
+    // player ended it from the pause screen
+    bool suspended = quitPressed && !endPressed && !botControlled && statistics["totalPieces"] > 0 &&
+                     suspend(suspendPath());
+    if (suspendRequested) {
+        // the terminal is gone (hangup or kill), nothing is left to return to
+        if (!suspended) recordResult();
+        InputReader::restoreTerminal();
+        std::exit(0);
+    }
+    if (suspended) return;
+    finish();
+}
+
+void Game::endSuspended() {
+    quitPressed = true;
+    endPressed = true;
+    finish();
+}
+
+void Game::recordResult() {
+    if (botControlled || statistics["totalPieces"] == 0) return;
+    GameHistory::record(Settings::getMode(), rngSeed, gameTime, !quitPressed && !toppedOut, statistics);
+    exportResult();
+}
+
+void Game::finish() {
+    recordResult();
+
+    std::vector<std::pair<std::string, std::string>> sprintLines;
+    if (!quitPressed && Settings::getMode().find("sprint_") == 0) sprintLines = finishSprint();
+
+    if (!quitPressed || endPressed || Settings::getMode() == "zen" || Settings::getMode() == "finesse") {
+        UI::showResultsPage(Settings::getMode(), statistics, gameTime, rolling.timeline(gameTime), sprintLines);
+        reset();
+    }
+}
+
+void Game::exportResult() {
+    if (!ResultsExport::isEnabled()) return;
+    std::string mode = Settings::getMode();
+    ResultsExport::Result result{};
+    result.mode = mode.c_str();
+    result.finishedAt = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    result.seed = rngSeed;
+    result.time = gameTime;
+    result.completed = !quitPressed && !toppedOut;
+    result.arr = arr;
+    result.das = das;
+    result.dcd = dcd;
+    result.sdf = sdf;
+    for (int i = 0; i < GameHistory::COUNTER_COUNT; ++i) {
+        auto it = statistics.find(GameHistory::counterName(i));
+        result.counters[i] = it == statistics.end() ? 0 : it->second;
+    }
+    result.splitCount = splitCount;
+    std::copy(splits.begin(), splits.begin() + splitCount, result.splits);
+    ResultsExport::write(result);
+    ResultsExport::flush(); // interrupting the session later must not lose this game
+}
+
+std::vector<std::pair<std::string, std::string>> Game::finishSprint() {
+    std::vector<std::pair<std::string, std::string>> lines;
+    std::string mode = Settings::getMode();
+    if (statistics["lines"] < sprintTarget(mode)) return lines; // topped out, nothing to rank
+
+    Leaderboard::Run run{};
+    mode.copy(run.mode, sizeof(run.mode) - 1);
+    run.finishedAt = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    run.time = gameTime;
+    run.splitCount = splitCount;
+    std::copy(splits.begin(), splits.begin() + splitCount, run.splits);
+    bool newBest = Leaderboard::record(run);
+
+    auto delta = [](double seconds) {
+        char buf[16];
+        snprintf(buf, sizeof(buf), "%+.3f", seconds);
+        return std::string(buf);
+    };
+    if (pbTime > 0.0) {
+        lines.emplace_back(newBest ? "Personal Best (old)" : "Personal Best",
+                           UI::formatSeconds(pbTime) + " " + delta(gameTime - pbTime));
+    } else if (newBest) {
+        lines.emplace_back("Personal Best", "first run");
+    }
+    for (int i = 0; i < splitCount; ++i) {
+        std::string value = UI::formatSeconds(splits[i]);
+        if (i < pbSplitCount) value += " " + delta(splits[i] - pbSplits[i]);
+        lines.emplace_back("Split " + std::to_string((i + 1) * Leaderboard::SPLIT_LINES) + "L", value);
+    }
+    return lines;
+}
+
+double Game::waitWhilePaused(const Settings& settings) {
+    auto pauseStartTime = std::chrono::steady_clock::now();
+    UI::showPauseScreen();
+    const auto& pauseKeys = settings.getKeys(Settings::ACTION_PAUSE);
+    const auto& quitKeys = settings.getKeys(Settings::ACTION_QUIT);
+    std::vector<InputEvent> input;
+    while (isPaused) {
+        input.clear();
+        InputReader::drain(input);
+        if (InputReader::applyTerminalChanges()) relayoutRequested = true;
+        for (const auto& event : input) {
+            if (event.type != InputEvent::PRESS) continue;
+            if (pauseKeys.contains(event.key)) {
+                isPaused = false;
+                break;
+            } else if (quitKeys.contains(event.key)) {
+                // quitting from here ends the game for good, quitting during play suspends it
+                isPaused = false;
+                quitPressed = true;
+                endPressed = true;
+                isRunning = false;
+                break;
             }
-        } else {
-            leftInitial = true;
-            leftDCD = false;
-        }
-
-        if (rightHeld && (!leftHeld || lastDirection == 1)) {
-            float delay = rightInitial ? das : (rightDCD ? dcd : arr);
-            if (rightInitial || rightDCD || rightDuration >= delay) { // only using rightInitial and rightDCD
-                Tetromino moved = currentPiece;
-                moved.moveRight();
-                if (GameUtils::canPlace(moved, board)) {
-                    currentPiece.moveRight();
-                    lastRight = now;
-                }
-                if (rightInitial) rightInitial = false;
-                if (rightDCD) rightDCD = false;
+        }
+        if (suspendRequested) {
+            isPaused = false;
+            quitPressed = true;
+            isRunning = false;
+        }
+        if (isPaused) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    auto pauseEndTime = std::chrono::steady_clock::now();
+    double pausedSeconds = std::chrono::duration<double>(pauseEndTime - pauseStartTime).count();
+    totalPausedDuration += pausedSeconds;
+    simClock = pauseEndTime; // paused time is not simulated
+    UI::clearScreen();
+    invalidate();
+    return pausedSeconds;
+}
+
+void Game::step(const Settings& settings, const std::vector<InputEvent>& input) {
+    // settings saved elsewhere apply mid-game; shifts in progress keep their das timers
+    Settings::reload();
+    if (settingsGeneration != Settings::generation()) {
+        applySettings(settings);
+        dirty |= DIRTY_STATIC;
+    }
+
+    for (const auto& event : input) {
+        if (event.key == KEY_RESIZE) relayoutRequested = true;
+        // the renderer takes the overlay down and repaints underneath it
+        if (event.type == InputEvent::PRESS && event.key == KEY_F(3)) Profiler::toggleOverlay();
+    }
+
+    if (practiceMode) {
+        // undo on u or backspace, redo on y, unless those keys are bound to something else
+        for (const auto& event : input) {
+            if (event.type != InputEvent::PRESS) continue;
+            bool bound = false;
+            for (int a = 0; a < Settings::ACTION_COUNT && !bound; a++) {
+                bound = settings.getKeys(static_cast<Settings::Action>(a)).contains(event.key);
             }
-        } else {
-            rightInitial = true;
-            rightDCD = false;
+            if (bound) continue;
+            const PracticeHistory::State* state = nullptr;
+            if (event.key == 'u' || event.key == KEY_BACKSPACE || event.key == 127 || event.key == 8) {
+                state = history.undo();
+            } else if (event.key == 'y') {
+                state = history.redo();
+            }
+            if (state) restoreState(*state);
         }
+    }
 
-        if (softDropHeld) {
-            if (softDropDuration >= sdf) {
-                Tetromino moved = currentPiece;
-                moved.setY(currentPiece.getY() + 1);
-                if (GameUtils::canPlace(moved, board)) {
-                    currentPiece.setY(currentPiece.getY() + 1);
-                    lastSoftDrop = now;
-                }
+    if (botControlled) {
+        // bots only listen for pause and quit
+        const auto& pauseKeys = settings.getKeys(Settings::ACTION_PAUSE);
+        const auto& quitKeys = settings.getKeys(Settings::ACTION_QUIT);
+        for (const auto& event : input) {
+            if (event.type != InputEvent::PRESS) continue;
+            if (pauseKeys.contains(event.key)) {
+                isPaused = !isPaused;
+            } else if (quitKeys.contains(event.key)) {
+                quitPressed = true;
+                isRunning = false;
             }
         }
+        Profiler::Scope timer(Profiler::UPDATE);
+        int ticks = pendingTicks();
+        for (int i = 0; i < ticks && isRunning && !isPaused; ++i) {
+            simClock += tickDuration;
+            if (spawnPending && simClock >= spawnAt) spawnPiece();
+            double sinceSpawn = std::chrono::duration<double>(simClock - pieceSpawnTime).count();
+            if (!spawnPending && sinceSpawn * botPps >= 1.0) playBotMove();
+            update();
+        }
+        publish();
+        return;
+    }
+
+    // with the kitty protocol held state comes from real press/release events; legacy terminals
+    // either use the estimator (shifts only) or count a key as held while it keeps repeating
+    bool releases = InputReader::reportsReleases();
+    bool estimated = !releases && holdEstimation;
+    const std::vector<InputEvent>* events = &input;
+    if (estimated) {
+        estimatedInput.clear();
+        holdEstimator.process(input, estimatedInput, std::chrono::steady_clock::now());
+        events = &estimatedInput;
+    }
+    if (!releases) {
+        for (const auto& event : *events) {
+            if (event.type != InputEvent::PRESS) continue;
+            if (settings.getKeys(Settings::ACTION_LEFT).contains(event.key)) leftSeen = event.time;
+            if (settings.getKeys(Settings::ACTION_RIGHT).contains(event.key)) rightSeen = event.time;
+            if (settings.getKeys(Settings::ACTION_SOFT_DROP).contains(event.key)) softDropSeen = event.time;
+        }
+    }
 
+    // each key is applied on the tick it arrived in, then autoshift, soft drop, gravity and
+    // lock delay advance one tick at a time, so the outcome no longer depends on the frame rate
+    Profiler::Scope timer(Profiler::UPDATE);
+    int ticks = pendingTicks();
+    size_t next = 0;
+    for (int i = 0; i < ticks && isRunning && !isPaused; ++i) {
+        simClock += tickDuration;
+        while (next < events->size() && (*events)[next].time <= simClock) {
+            applyEvent(settings, (*events)[next++]);
+        }
+        if (!isRunning || isPaused) break;
+        if (!releases) expireHeldKeys(estimated);
+        if (spawnPending && simClock >= spawnAt) spawnPiece();
+        autoshift(releases, estimated);
         update();
-        render();
-        std::this_thread::sleep_for(std::chrono::milliseconds(16)); // ~60 FPS
     }
+    // keys newer than the last whole tick are less than a tick early
+    while (next < events->size()) applyEvent(settings, (*events)[next++]);
+    publish();
+}
 
-    if (!quitPressed || Settings::getMode() == "zen") {
-        UI::showResultsPage(Settings::getMode(), statistics, gameTime);
-        reset();
+int Game::pendingTicks() {
+    auto now = std::chrono::steady_clock::now();
+    // after a stall (a suspended process, a slow terminal) skip ahead rather than replay it all
+    if (now - simClock > MAX_CATCH_UP) simClock = now - MAX_CATCH_UP;
+    return (int)((now - simClock) / tickDuration);
+}
+
+void Game::applyEvent(const Settings& settings, const InputEvent& event) {
+    int ch = event.key;
+    for (int a = 0; a < Settings::ACTION_COUNT; a++) {
+        Settings::Action action = static_cast<Settings::Action>(a);
+        for (int key : settings.getKeys(action)) {
+            if (ch == key) {
+                if (event.type == InputEvent::RELEASE) {
+                    if (action == Settings::ACTION_LEFT) { leftHeld = false; leftInitial = true; leftDCD = false; }
+                    else if (action == Settings::ACTION_RIGHT) { rightHeld = false; rightInitial = true; rightDCD = false; }
+                    else if (action == Settings::ACTION_SOFT_DROP) { softDropHeld = false; }
+                    continue;
+                }
+                if (event.type == InputEvent::REPEAT) {
+                    // das and arr are timed here, a repeat only proves the key is still down
+                    if (action == Settings::ACTION_LEFT) leftRepeatSeen = true;
+                    else if (action == Settings::ACTION_RIGHT) rightRepeatSeen = true;
+                    continue;
+                }
+                if (action == Settings::ACTION_LEFT) {
+                    if (!leftHeld) {
+                        // from neutral, use DAS
+                        leftInitial = true;
+                        leftDCD = false;
+                        leftPressTime = event.time;
+                        leftRepeatSeen = false;
+                    } else if (lastDirection != -1) {
+                        // switching direction, use DCD
+                        leftDCD = true;
+                        leftInitial = false;
+                        leftPressTime = event.time;
+                    }
+                    leftHeld = true;
+                    lastDirection = -1;
+                } else if (action == Settings::ACTION_RIGHT) {
+                    if (!rightHeld) {
+                        rightInitial = true;
+                        rightDCD = false;
+                        rightPressTime = event.time;
+                        rightRepeatSeen = false;
+                    } else if (lastDirection != 1) {
+                        rightDCD = true;
+                        rightInitial = false;
+                        rightPressTime = event.time;
+                    }
+                    rightHeld = true;
+                    lastDirection = 1;
+                } else if (action == Settings::ACTION_SOFT_DROP) {
+                    softDropHeld = true;
+                } else {
+                    handleInput(settings, ch);
+                }
+            }
+        }
+    }
+}
+
+void Game::expireHeldKeys(bool estimated) {
+    // the estimator already turned shifts into presses and releases
+    if (!estimated) {
+        if (leftHeld && simClock - leftSeen > heldWindow) { leftHeld = false; leftInitial = true; leftDCD = false; }
+        if (rightHeld && simClock - rightSeen > heldWindow) { rightHeld = false; rightInitial = true; rightDCD = false; }
+    }
+    if (softDropHeld && simClock - softDropSeen > heldWindow) softDropHeld = false;
+}
+
+void Game::autoshift(bool releases, bool estimated) {
+    if (spawnPending) return; // held shifts keep their das charge for the next piece
+    const auto now = simClock;
+    // when held state is known, autoshift waits out das from the press; the estimator also
+    // waits for the first repeat, since until then a tap and a hold look the same
+    auto charged = [&](std::chrono::steady_clock::time_point pressTime, bool repeatSeen) {
+        if (!releases && !estimated) return true; // the terminal's repeat delay acts as das
+        double held = std::chrono::duration<double, std::milli>(now - pressTime).count();
+        return held >= das && (!estimated || repeatSeen);
+    };
+    bool leftCharged = charged(leftPressTime, leftRepeatSeen);
+    bool rightCharged = charged(rightPressTime, rightRepeatSeen);
+    auto leftDuration = std::chrono::duration_cast<std::chrono::milliseconds>(now - lastLeft).count();
+    auto rightDuration = std::chrono::duration_cast<std::chrono::milliseconds>(now - lastRight).count();
+    auto softDropDuration = std::chrono::duration_cast<std::chrono::milliseconds>(now - lastSoftDrop).count();
+
+    if (leftHeld && (!rightHeld || lastDirection == -1)) {
+        float delay = leftInitial ? das : (leftDCD ? dcd : arr);
+        if (leftInitial || leftDCD || (leftCharged && leftDuration >= delay)) { // only using leftInitial and leftDCD
+            Tetromino moved = currentPiece;
+            moved.moveLeft();
+            if (GameUtils::canPlace(moved, board)) {
+                currentPiece.moveLeft();
+                noteInput(leftInitial || leftDCD ? 'L' : 'l');
+                lastLeft = (leftInitial || leftDCD) ? leftPressTime : now;
+                dirty |= DIRTY_BOARD;
+                settle();
+            }
+            if (leftInitial) leftInitial = false;
+            if (leftDCD) leftDCD = false;
+        }
+    } else {
+        leftInitial = true;
+        leftDCD = false;
+    }
+
+    if (rightHeld && (!leftHeld || lastDirection == 1)) {
+        float delay = rightInitial ? das : (rightDCD ? dcd : arr);
+        if (rightInitial || rightDCD || (rightCharged && rightDuration >= delay)) { // only using rightInitial and rightDCD
+            Tetromino moved = currentPiece;
+            moved.moveRight();
+            if (GameUtils::canPlace(moved, board)) {
+                currentPiece.moveRight();
+                noteInput(rightInitial || rightDCD ? 'R' : 'r');
+                lastRight = (rightInitial || rightDCD) ? rightPressTime : now;
+                dirty |= DIRTY_BOARD;
+                settle();
+            }
+            if (rightInitial) rightInitial = false;
+            if (rightDCD) rightDCD = false;
+        }
+    } else {
+        rightInitial = true;
+        rightDCD = false;
+    }
+
+    if (softDropHeld) {
+        if (softDropDuration >= sdf) {
+            Tetromino moved = currentPiece;
+            moved.setY(currentPiece.getY() + 1);
+            if (GameUtils::canPlace(moved, board)) {
+                currentPiece.setY(currentPiece.getY() + 1);
+                noteInput('D');
+                lastSoftDrop = now;
+                dirty |= DIRTY_BOARD;
+            }
+        }
     }
 }
 
 void Game::handleInput(const Settings& settings, int ch) {
-    const auto& keyBindings = settings.getKeyBindings();
-    for (const auto& [action, keys] : keyBindings) {
-        for (int key : keys) {
+    Trace::Span span("handleInput");
+    if (spawnPending) {
+        // no piece in play: rotations and hold wait for the spawn, a hard drop has nothing to drop
+        if (settings.getKeys(Settings::ACTION_ROTATE_CW).contains(ch)) {
+            bufferedRotation = (bufferedRotation + 1) % 4;
+            return;
+        } else if (settings.getKeys(Settings::ACTION_ROTATE_CCW).contains(ch)) {
+            bufferedRotation = (bufferedRotation + 3) % 4;
+            return;
+        } else if (settings.getKeys(Settings::ACTION_FLIP).contains(ch)) {
+            bufferedRotation = (bufferedRotation + 2) % 4;
+            return;
+        } else if (settings.getKeys(Settings::ACTION_HOLD).contains(ch)) {
+            bufferedHold = true;
+            return;
+        } else if (settings.getKeys(Settings::ACTION_HARD_DROP).contains(ch)) {
+            return;
+        }
+    }
+    for (int a = 0; a < Settings::ACTION_COUNT; a++) {
+        Settings::Action action = static_cast<Settings::Action>(a);
+        for (int key : settings.getKeys(action)) {
             if (ch == key) {
-                if (action == "ROTATE_CW") {
+                if (action == Settings::ACTION_ROTATE_CW) {
                     Tetromino rotated = currentPiece;
                     rotated.rotateCW(board);
                     bool kicked = !GameUtils::canPlace(rotated, board);
                     if (GameUtils::canPlace(rotated, board)) {
                         currentPiece.rotateCW(board);
+                        noteInput('C');
                         lastRotation = kicked ? 2 : 1;
                     } else {
                         lastRotation = 0;
                     }
-                } else if (action == "ROTATE_CCW") {
+                } else if (action == Settings::ACTION_ROTATE_CCW) {
                     Tetromino rotated = currentPiece;
                     rotated.rotateCCW(board);
                     bool kicked = !GameUtils::canPlace(rotated, board);
                     if (GameUtils::canPlace(rotated, board)) {
                         currentPiece.rotateCCW(board);
+                        noteInput('W');
                         lastRotation = kicked ? 2 : 1;
                     } else {
                         lastRotation = 0;
                     }
-                } else if (action == "FLIP") {
+                } else if (action == Settings::ACTION_FLIP) {
                     Tetromino rotated = currentPiece;
                     rotated.rotate180(board);
                     bool kicked = !GameUtils::canPlace(rotated, board);
                     if (GameUtils::canPlace(rotated, board)) {
                         currentPiece.rotate180(board);
+                        noteInput('F');
                         lastRotation = kicked ? 2 : 1;
                     } else {
                         lastRotation = 0;
                     }
-                } else if (action == "HOLD") {
-                    if (holdAvailable) {
-                        currentPiece.setRotationState(0);
-                        currentPiece.setX(3);
-                        currentPiece.setY(20);
-                        if (holdPiece.getType() != 0) {
-                            std::swap(currentPiece, holdPiece);
-                        } else {
-                            holdPiece = currentPiece;
-                            Game::newPiece();
-                        }
-                        holdAvailable = false;
-                        lastRotation = 0;
-                    }
-                } else if (action == "HARD_DROP") {
-                    Tetromino moved = currentPiece;
-                    while (GameUtils::canPlace(moved, board)) {
-                        currentPiece.setY(moved.getY());
-                        moved.setY(moved.getY() + 1);
-                    }
-                    GameUtils::placePiece(currentPiece, board);
-                    processLineClear();
-
-                    newPiece();
-
-                    lastRotation = 0;
-                    holdAvailable = true;
-                    lastFallTime = std::chrono::steady_clock::now();
+                } else if (action == Settings::ACTION_HOLD) {
+                    hold();
+                } else if (action == Settings::ACTION_HARD_DROP) {
+                    hardDrop();
                     return;
-                } else if (action == "QUIT") {
+                } else if (action == Settings::ACTION_QUIT) {
                     quitPressed = true;
                     isRunning = false;
-                } else if (action == "RESTART") {
-                    reset();
-                } else if (action == "PAUSE") {
+                } else if (action == Settings::ACTION_RESTART) {
+                    if (Settings::getMode() == "versus") {
+                        // both engines restart together, the versus loop handles it
+                        restartPressed = true;
+                    } else {
+                        reset();
+                    }
+                } else if (action == Settings::ACTION_PAUSE) {
                     isPaused = !isPaused;
                 }
-                refresh();
             }
         }
     }
-    refresh();
-
-    Tetromino moved = currentPiece;
-    moved.setY(currentPiece.getY() + 1);
+    if (spawnPending) return; // quit, pause or restart during the delay
+    dirty |= DIRTY_BOARD;
+    settle();
 
     // reset lock delay if piece falling
-    if (!GameUtils::canPlace(moved, board)) {
+    if (dropDistance() == 0) {
         lockDelayActive = false;
     }
 }
 
-void Game::processLineClear() {
+void Game::hold() {
+    if (!holdAvailable) return;
+    Trace::instant("hold");
+    currentPiece.setRotationState(0);
+    currentPiece.setX(3);
+    currentPiece.setY(20);
+    if (holdPiece.getType() != 0) {
+        std::swap(currentPiece, holdPiece);
+    } else {
+        holdPiece = currentPiece;
+        Game::newPiece();
+    }
+    holdAvailable = false;
+    lastRotation = 0;
+    clearPieceInputs();
+    noteInput('H');
+    dirty |= DIRTY_BOARD | DIRTY_HOLD;
+}
+
+void Game::hardDrop() {
+    currentPiece.setY(currentPiece.getY() + dropDistance());
+    noteInput('V');
+    GameUtils::placePiece(currentPiece, board);
+    scheduleSpawn(processLineClear());
+
+    lastRotation = 0;
+    holdAvailable = true;
+    fallProgress = 0.0;
+    recordPlacement();
+}
+
+void Game::playBotMove() {
+    auto rows = Bitboard::fromBoard(board);
+    char nextType = bag.empty() ? 0 : bag.front().getType();
+    Bot::Move move = holdAvailable
+        ? Bot::findMove(rows.data(), currentPiece.getType(), holdPiece.getType(), nextType)
+        : Bot::findMove(rows.data(), currentPiece.getType(), 0, 0);
+
+    if (move.valid) {
+        if (move.useHold) hold();
+        if (move.rotation == 1) currentPiece.rotateCW(board);
+        else if (move.rotation == 2) currentPiece.rotate180(board);
+        else if (move.rotation == 3) currentPiece.rotateCCW(board);
+        lastRotation = move.rotation != 0 ? 1 : 0;
+        while (currentPiece.getX() != move.x) {
+            Tetromino moved = currentPiece;
+            moved.setX(currentPiece.getX() + (move.x > currentPiece.getX() ? 1 : -1));
+            if (!GameUtils::canPlace(moved, board)) break;
+            currentPiece = moved;
+        }
+    }
+    hardDrop();
+}
+
+void Game::setBotControlled(bool enabled, float piecesPerSecond) {
+    botControlled = enabled;
+    botPps = piecesPerSecond;
+}
+
+void Game::receiveGarbage(int lines) {
+    if (lines <= 0) return;
+    auto readyTime = simClock + std::chrono::milliseconds(garbageDelayMs);
+    incomingGarbage.push_back({lines, readyTime});
+    dirty |= DIRTY_BOARD;
+}
+
+int Game::takeOutgoingAttack() {
+    int attack = outgoingAttack;
+    outgoingAttack = 0;
+    return attack;
+}
+
+void Game::applyGarbage() {
+    auto now = simClock;
+    int inserted = 0;
+    while (!incomingGarbage.empty() && inserted < garbageCap) {
+        auto& garbage = incomingGarbage.front();
+        if (garbage.readyTime > now) break;
+        int lines = std::min(garbage.lines, garbageCap - inserted);
+        GameUtils::generateGarbageLines(board, lines);
+        inserted += lines;
+        garbage.lines -= lines;
+        if (garbage.lines == 0) incomingGarbage.pop_front();
+    }
+    if (inserted > 0) dirty |= DIRTY_BOARD;
+}
+
+int Game::processLineClear() {
+    Trace::Span span("processLineClear");
+    Trace::instant("lock");
+    boardRowsStale = true; // the piece was just placed
+    if (Settings::getMode() == "finesse") {
+        checkFinesse();
+    }
     auto clearInfo = GameUtils::checkClearConditions(currentPiece, board, lastRotation);
+    double lockTime = std::chrono::duration<double>(simClock - gameStart).count() - totalPausedDuration;
 
     if (clearInfo.lines > 0) {
+        Trace::instant("line clear");
         if (Settings::getMode().find("cheese_") == 0) {
             statistics["cheeseCleared"] += clearInfo.cheeseCleared;
             cheeseCount += clearInfo.cheeseCleared;
         }
-        statistics["attack"] += GameUtils::calculateAttack(clearInfo, statistics["b2bStreak"], statistics["combo"]);
+        int attack = GameUtils::calculateAttack(clearInfo, statistics["b2bStreak"], statistics["combo"]);
+        int pieceAttack = attack;
+        statistics["attack"] += attack;
+        if (Settings::getMode() == "versus") {
+            // attack cancels queued incoming garbage first, the rest goes to the opponent
+            while (attack > 0 && !incomingGarbage.empty()) {
+                int cancelled = std::min(attack, incomingGarbage.front().lines);
+                incomingGarbage.front().lines -= cancelled;
+                attack -= cancelled;
+                if (incomingGarbage.front().lines == 0) incomingGarbage.pop_front();
+            }
+            outgoingAttack += attack;
+        }
         statistics["score"] += GameUtils::calculateScore(clearInfo, statistics["b2bStreak"], statistics["combo"]);
         statistics["lines"] += clearInfo.lines;
         statistics["combo"] = std::max(0, statistics["combo"]) + 1;
@@ -370,18 +1223,26 @@ void Game::processLineClear() {
             statistics["b2bStreak"] = 0;
         }
         statistics["max_combo"] = std::max(statistics["max_combo"], statistics["combo"]);
+        logPiece(clearInfo, pieceAttack);
+        rolling.record(lockTime, pieceAttack, clearInfo.cheeseCleared);
 
         generatePopup(clearInfo);
+        applyLevel();
         
         std::string currentMode = Settings::getMode();
         if (currentMode.find("sprint_") == 0) {
-            int target = 0;
-            if (currentMode == "sprint_20l") target = 20;
-            else if (currentMode == "sprint_40l") target = 40;
-            else if (currentMode == "sprint_100l") target = 100;
-            if (statistics["lines"] >= target) {
+            while (splitCount < Leaderboard::MAX_SPLITS &&
+                   statistics["lines"] >= (splitCount + 1) * Leaderboard::SPLIT_LINES) {
+                splits[splitCount] = lockTime;
+                if (splitCount < pbSplitCount) {
+                    paceDelta = lockTime - pbSplits[splitCount];
+                    paceKnown = true;
+                }
+                splitCount++;
+            }
+            if (statistics["lines"] >= sprintTarget(currentMode)) {
                 isRunning = false;
-                return;
+                return clearInfo.lines;
             }
         } else if (currentMode.find("cheese_") == 0) {
             int target = 0;
@@ -390,12 +1251,24 @@ void Game::processLineClear() {
             else if (currentMode == "cheese_100l") target = 100;
             if (statistics["cheeseCleared"] >= target) {
                 isRunning = false;
-                return;
+                return clearInfo.lines;
+            }
+        } else if (currentMode == "marathon" || currentMode == "master") {
+            if (statistics["lines"] >= MARATHON_LINES) {
+                isRunning = false;
+                return clearInfo.lines;
             }
         }
     } else {
         // combo break
         statistics["combo"] = 0;
+        logPiece(clearInfo, 0);
+        rolling.record(lockTime, 0, 0);
+
+        // received garbage rises when a piece locks without clearing
+        if (Settings::getMode() == "versus") {
+            applyGarbage();
+        }
         
         // regenerate cheese lines
         if (Settings::getMode().find("cheese_") == 0) {
@@ -416,13 +1289,82 @@ void Game::processLineClear() {
     }
 
     holdAvailable = true;
-    lastFallTime = std::chrono::steady_clock::now();
+    fallProgress = 0.0;
+    dirty |= DIRTY_BOARD | DIRTY_STATS;
+    return clearInfo.lines;
+}
+
+void Game::noteInput(char action) {
+    if (pieceInputCount < (int)pieceInputs.size() - 1) {
+        pieceInputs[pieceInputCount] = action;
+    }
+    pieceInputCount++;
+    // kept apart from the log, which autoshift repeats can fill before the piece locks
+    piecePresses += Finesse::countInputs(&action, 1);
+    pieceSoftDropped |= !Finesse::isJudgeable(&action, 1);
+}
+
+void Game::clearPieceInputs() {
+    pieceInputCount = 0;
+    piecePresses = 0;
+    pieceSoftDropped = false;
+}
+
+void Game::logPiece(const GameUtils::ClearInfo& info, int attack) {
+    if (!Telemetry::isEnabled() || botControlled) return;
+    Telemetry::PieceRecord piece{};
+    piece.game = gameId;
+    std::string mode = Settings::getMode();
+    mode.copy(piece.mode, sizeof(piece.mode) - 1);
+    piece.piece = statistics["totalPieces"];
+    piece.type = currentPiece.getType();
+    piece.x = currentPiece.getX();
+    piece.y = currentPiece.getY();
+    piece.rotation = currentPiece.getRotationState();
+    int logged = std::min(pieceInputCount, Telemetry::MAX_INPUTS);
+    std::copy(pieceInputs.begin(), pieceInputs.begin() + logged, piece.inputs);
+    piece.inputCount = std::min(pieceInputCount, 255);
+    piece.lockMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        simClock - pieceSpawnTime).count();
+    piece.lines = info.lines;
+    piece.attack = attack;
+    piece.tspin = info.tspin;
+    piece.mini = info.mini;
+    piece.pc = info.pc;
+    piece.b2b = statistics["b2bStreak"];
+    piece.combo = statistics["combo"];
+    Telemetry::record(piece);
+}
+
+void Game::checkFinesse() {
+    // kicked rotations and soft drop tucks can't be reached by the empty-board table
+    if (lastRotation == 2 || pieceSoftDropped) return;
+    int optimal = Finesse::optimalInputs(currentPiece.getType(), currentPiece.getRotationState(), currentPiece.getX());
+    if (optimal < 0) return;
+
+    int used = piecePresses;
+    statistics["finessePieces"]++;
+    if (used > optimal) {
+        statistics["finesseFaults"]++;
+        statistics["finesseExtra"] += used - optimal;
+        showPopup("FINESSE FAULT\n" + std::to_string(used) + " keys, " + std::to_string(optimal) + " needed", 1.5);
+    }
+    dirty |= DIRTY_STATS;
 }
 
 void Game::showPopup(const std::string& text, float durationSeconds) {
-    popupText = text;
+    popupLines.clear();
+    popupMaxLen = 0;
+    size_t pos = 0, prev = 0;
+    while ((pos = text.find('\n', prev)) != std::string::npos) {
+        popupLines.emplace_back(text.substr(prev, pos - prev));
+        prev = pos + 1;
+    }
+    popupLines.emplace_back(text.substr(prev));
+    for (const auto& l : popupLines) popupMaxLen = std::max(popupMaxLen, l.size());
     popupStartTime = std::chrono::steady_clock::now();
     popupDurationSeconds = durationSeconds;
+    dirty |= DIRTY_POPUP;
 }
 
 void Game::generatePopup(const GameUtils::ClearInfo& info) {
@@ -459,7 +1401,8 @@ void Game::generatePopup(const GameUtils::ClearInfo& info) {
 }
 
 void Game::update() {
-    auto now = std::chrono::steady_clock::now();
+    Trace::Span span("update");
+    auto now = simClock; // one tick of engine time, see step
     
     // Check for blitz mode time limit
     std::string currentMode = Settings::getMode();
@@ -481,37 +1424,60 @@ void Game::update() {
         }
     }
 
-    Tetromino moved = currentPiece;
-    moved.setY(currentPiece.getY() + 1);
+    if (spawnPending) {
+        // between pieces: no gravity or lock delay, only the clock runs
+        gameTime = std::chrono::duration<double>(now - gameStart).count() - totalPausedDuration;
+        return;
+    }
 
-    if (!GameUtils::canPlace(moved, board)) {
+    int below = practiceMode ? 0 : dropDistance();
+
+    if (practiceMode) {
+        // no gravity and no lock delay, pieces only lock on hard drop
+        lockDelayActive = false;
+    } else if (below == 0) {
         // on the ground: lock delay logic
+        fallProgress = 0.0;
         if (!lockDelayActive) {
             lockDelayActive = true;
             lockStartTime = now;
         }
         if (lockDelayActive && std::chrono::duration_cast<std::chrono::milliseconds>(now - lockStartTime).count() >= lockDelayMs) {
             GameUtils::placePiece(currentPiece, board);
-            processLineClear();
-            newPiece();
+            scheduleSpawn(processLineClear());
             holdAvailable = true;
             lastRotation = 0;
             lockDelayActive = false;
-            lastFallTime = now;
+            fallProgress = 0.0;
+            recordPlacement();
         }
     } else {
-        // not on the ground: gravity logic
+        // not on the ground: gravity, as many rows as this tick owes but never through the stack
         lockDelayActive = false;
-        if (std::chrono::duration_cast<std::chrono::milliseconds>(now - lastFallTime).count() >= fallDelay) {
-            currentPiece.setY(currentPiece.getY() + 1);
-            lastFallTime = now;
+        fallProgress += gravity * std::chrono::duration<double, std::milli>(tickDuration).count();
+        if (gravity >= GameUtils::INSTANT_GRAVITY) fallProgress = below;
+        if (fallProgress >= 1.0) {
+            int fall = std::min((int)fallProgress, below);
+            currentPiece.setY(currentPiece.getY() + fall);
+            fallProgress -= (int)fallProgress;
+            dirty |= DIRTY_BOARD;
         }
     }
 
     gameTime = std::chrono::duration<double>(now - gameStart).count() - totalPausedDuration;
 }
 
-void Game::render() {
+// windows are only staged here, the frame reaches the terminal in UI::flushFrame
+static void present(WINDOW* win) {
+    UI::stage(win);
+}
+
+void Game::computeLayout(const Frame& frame) {
+    releaseWindows();
+    layout.valid = true;
+    // a game that owns the whole terminal clears what the old geometry left behind
+    if (viewportWidth == 0) UI::clearScreen();
+
     int term_rows, term_cols;
     getmaxyx(stdscr, term_rows, term_cols);
     int board_width = 10;
@@ -522,21 +1488,74 @@ void Game::render() {
     int box_width = 12;
     int box_height = 6;
 
-    int start_y = (term_rows - board_height) / 2;
-    int start_x = (term_cols - win_width) / 2;
+    int area_x = viewportX;
+    int area_width = viewportWidth > 0 ? viewportWidth : term_cols;
+    int start_y = std::max(0, (term_rows - board_height) / 2);
+    int start_x = area_x + (area_width - win_width) / 2;
 
-    auto now = std::chrono::steady_clock::now();
+    int hold_x = start_x - box_width - 2;
+    int hold_y = start_y;
+    int stats_height = 12;
+    int stats_width = box_width;
+    int stats_y = hold_y + box_height + 1;
+    int stats_x = hold_x;
+    int piece_gap = -2;
+    int next_x = start_x + win_width + 2;
+    int next_y = start_y;
+    int next_box_height = (box_height + piece_gap) * 4 + 2;
+    int next_box_width = box_width;
+    int handling_height = 6;
+    int handling_width = box_width;
+    int handling_y = next_y + next_box_height + 1;
+    int handling_x = next_x;
 
-    // board window
-    WINDOW* boardwin = newwin(win_height, win_width, start_y, start_x);
-    box(boardwin, 0, 0);
-    UI::renderBoard(boardwin, board, board_height, board_width, cell_width);
-    UI::renderGhostPiece(boardwin, currentPiece, board, cell_width);
-    UI::renderTetromino(boardwin, currentPiece, cell_width, false);
-    wrefresh(boardwin);
+    int title_y = start_y - 1;
+    int main_stat_y = start_y + board_height + 2;
+    int rates_height = 6;
+    int rates_width = 24;
+    int rates_y = stats_y + stats_height + 1;
+    int rates_x = start_x - rates_width - 2;
+    int popup_y = rates_y;
+    int popup_width = std::max(1, start_x - area_x);
+
+    auto fits = [&](int height, int width, int y, int x) {
+        return y >= 0 && x >= area_x && y + height <= term_rows && x + width <= area_x + area_width;
+    };
+    auto place = [&](int height, int width, int y, int x) -> WINDOW* {
+        return fits(height, width, y, x) ? newwin(height, width, y, x) : nullptr;
+    };
+
+    layout.fits = fits(win_height, win_width, start_y, start_x);
+    if (!layout.fits) {
+        char notice[48];
+        snprintf(notice, sizeof(notice), "Terminal too small (need %dx%d)", win_width, win_height);
+        int width = std::min((int)strlen(notice), area_width);
+        if (width > 0 && term_rows > 0) {
+            layout.noticewin = newwin(1, width, term_rows / 2, area_x + (area_width - width) / 2);
+            mvwaddnstr(layout.noticewin, 0, 0, notice, width);
+        }
+        redraw = DIRTY_ALL;
+        return;
+    }
+
+    // nothing is drawn on stdscr so side-by-side engines never widen each other's change ranges
+    layout.boardwin = newwin(win_height, win_width, start_y, start_x);
+    layout.holdwin = place(box_height, box_width, hold_y, hold_x);
+    layout.statswin = place(stats_height, stats_width, stats_y, stats_x);
+    // recent rates go under the stats when there is room, the popup moves down below them
+    layout.rateswin = place(rates_height, rates_width, rates_y, rates_x);
+    if (layout.rateswin) popup_y = rates_y + rates_height + 1;
+    layout.nextwin = place(next_box_height, next_box_width, next_y, next_x);
+    layout.handlingwin = place(handling_height, handling_width, handling_y, handling_x);
+    layout.titlewin = place(1, win_width, title_y, start_x);
+    layout.mainstatwin = place(1, win_width, main_stat_y, start_x);
+    layout.linkwin = place(1, win_width, main_stat_y + 1, start_x);
+    layout.popupwin = place(2, popup_width, popup_y, area_x);
+    layout.meterwin = place(board_height, 1, start_y + 1, start_x - 1);
+    layout.popupWidth = popup_width;
 
     // gamemode title text
-    std::string mode = Settings::getMode();
+    std::string mode = label.empty() ? frame.mode : label;
     mode[0] = std::toupper(mode[0]);
     size_t tmp = 0;
     // replace after _
@@ -559,121 +1578,378 @@ void Game::render() {
     for (auto& c : mode) {
         if (c == '_') c = ' ';
     }
-    int mode_x = start_x + (win_width - (int)mode.size()) / 2;
-    int mode_y = start_y - 1;
-    if (mode_y >= 0) {
-        mvprintw(mode_y, mode_x, "%s", mode.c_str());
-    }
+    layout.title = mode;
 
-    // main stat
-    std::string mainStat;
-    if (Settings::getMode() == "zen") {
+    // main stat shown under the board
+    const std::string& gameMode = frame.mode;
+    layout.mainStat = STAT_NONE;
+    layout.statTarget = 0;
+    layout.statTimeLimit = 0.0;
+    if (gameMode == "zen") {
         // incremental lines instead of target
-        mainStat = "Lines: " + std::to_string(statistics["lines"]);
-    } else if (Settings::getMode().find("sprint_") == 0) {
-        int target = 0;
-        if (Settings::getMode() == "sprint_20l") target = 20;
-        else if (Settings::getMode() == "sprint_40l") target = 40;
-        else if (Settings::getMode() == "sprint_100l") target = 100;
-        int left = std::max(0, target - statistics["lines"]);
-        mainStat = "Lines: " + std::to_string(left);
-    } else if (Settings::getMode().find("blitz_") == 0) {
-        double timeLimit = 0.0;
-        if (Settings::getMode() == "blitz_1min") timeLimit = 60.0;
-        else if (Settings::getMode() == "blitz_2min") timeLimit = 120.0;
-        else if (Settings::getMode() == "blitz_4min") timeLimit = 240.0;
-        double left = std::max(0.0, timeLimit - gameTime);
-        mainStat = "Time: " + UI::formatSeconds(left);
-    } else if (Settings::getMode().find("cheese_") == 0) {
-        int target = 0;
-        if (Settings::getMode() == "cheese_10l") target = 10;
-        else if (Settings::getMode() == "cheese_18l") target = 18;
-        else if (Settings::getMode() == "cheese_100l") target = 100;
-        int left = std::max(0, target - statistics["cheeseCleared"]);
-        mainStat = "Cheese: " + std::to_string(left);
-    }
-    int attack_x = start_x + (win_width - mainStat.size()) / 2;
-    int attack_y = start_y + board_height + 2;
-
-    int clear_len = std::max((int)mainStat.size(), 24);
-    std::string spaces(clear_len, ' ');
-    mvprintw(attack_y, start_x, "%s", spaces.c_str());
-    mvprintw(attack_y, attack_x, "%s", mainStat.c_str());
+        layout.mainStat = STAT_LINES;
+    } else if (gameMode == "versus") {
+        layout.mainStat = STAT_ATTACK;
+    } else if (gameMode == "finesse") {
+        layout.mainStat = STAT_FAULTS;
+    } else if (gameMode == "practice") {
+        layout.mainStat = STAT_UNDO;
+    } else if (gameMode == "marathon" || gameMode == "master") {
+        layout.mainStat = STAT_LEVEL;
+        layout.statTarget = MARATHON_LINES;
+    } else if (gameMode.find("sprint_") == 0) {
+        layout.mainStat = STAT_LINES_LEFT;
+        layout.statTarget = sprintTarget(gameMode);
+    } else if (gameMode.find("blitz_") == 0) {
+        layout.mainStat = STAT_TIME_LEFT;
+        if (gameMode == "blitz_1min") layout.statTimeLimit = 60.0;
+        else if (gameMode == "blitz_2min") layout.statTimeLimit = 120.0;
+        else if (gameMode == "blitz_4min") layout.statTimeLimit = 240.0;
+    } else if (gameMode.find("cheese_") == 0) {
+        layout.mainStat = STAT_CHEESE_LEFT;
+        if (gameMode == "cheese_10l") layout.statTarget = 10;
+        else if (gameMode == "cheese_18l") layout.statTarget = 18;
+        else if (gameMode == "cheese_100l") layout.statTarget = 100;
+    }
+    layout.shownStat[0] = '\0';
+    layout.shownLink[0] = '\0';
+    redraw = DIRTY_ALL;
+}
+
+void Game::publish() {
+    if (!dirty && simClock - lastPublish < PUBLISH_INTERVAL) return;
+    lastPublish = simClock;
+    Frame& frame = frames.back();
+    frame.sequence = ++publishedFrames;
+    for (int i = 0; i < REGION_COUNT; ++i) {
+        if (dirty & (1u << i)) revision[i]++;
+    }
+    dirty = 0;
+    // the slot still holds what was last published from it, so containers are only copied for
+    // regions that changed since; scalars are cheaper to copy than to check
+    unsigned stale = 0;
+    for (int i = 0; i < REGION_COUNT; ++i) {
+        if (frame.revision[i] != revision[i]) stale |= 1u << i;
+    }
+    frame.revision = revision;
+    if (stale & DIRTY_BOARD) frame.board = board;
+    frame.current = currentPiece;
+    frame.held = holdPiece;
+    frame.nextCount = std::min((int)bag.size(), (int)frame.next.size());
+    for (int i = 0; i < frame.nextCount; ++i) frame.next[i] = bag[i];
+    if (stale & DIRTY_STATS) frame.statistics = statistics;
+    frame.gameTime = gameTime;
+    frame.rates = rolling.rates(gameTime);
+    frame.paceKnown = paceKnown;
+    frame.paceDelta = (float)paceDelta;
+    frame.pendingGarbage = 0;
+    for (const auto& garbage : incomingGarbage) frame.pendingGarbage += garbage.lines;
+    frame.undoDepth = history.undoDepth();
+    frame.redoDepth = history.redoDepth();
+    frame.pieceVisible = !spawnPending;
+    frame.arr = arr;
+    frame.das = das;
+    frame.dcd = dcd;
+    frame.sdf = sdf;
+    if (stale & DIRTY_STATIC) frame.mode = Settings::getMode();
+    frame.blockCharacter = Settings::getTetrominoCharacter();
+    if (stale & DIRTY_POPUP) frame.popupLines = popupLines;
+    frame.popupMaxLen = popupMaxLen;
+    frame.popupStartTime = popupStartTime;
+    frame.popupDurationSeconds = popupDurationSeconds;
+    frames.publish();
+}
+
+void Game::startRenderer() {
+    if (rendering) return;
+    rendering = true;
+    renderer = std::thread(&Game::renderLoop, this);
+}
+
+void Game::stopRenderer() {
+    if (!rendering) return;
+    rendering = false;
+    if (renderer.joinable()) renderer.join();
+}
+
+void Game::renderLoop() {
+    Trace::registerThread("render");
+    for (;;) {
+        // the engine may have published its final state just before stopping us
+        bool last = !rendering.load();
+        if (InputReader::applyTerminalChanges()) relayoutRequested = true;
+        render();
+        UI::flushFrame();
+        if (Profiler::isEnabled()) {
+            int64_t frameStart = Profiler::now();
+            if (lastFrameStart) Profiler::record(Profiler::FRAME, frameStart - lastFrameStart);
+            lastFrameStart = frameStart;
+        }
+        if (last) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(16)); // ~60 FPS
+    }
+    lastFrameStart = 0;
+}
+
+void Game::render() {
+    // requests from the engine side first, then the newest frame; regions are drawn when their
+    // revision moved, which also covers changes made in frames that were never drawn
+    if (relayoutRequested.exchange(false)) layout.valid = false;
+    if (redrawRequested.exchange(false)) {
+        redraw = DIRTY_ALL;
+        lastHudTick = -1;
+    }
+    if (Profiler::overlayVisible()) {
+        overlayShown = true;
+    } else if (overlayShown) {
+        overlayShown = false;
+        Profiler::hideOverlay();
+        redraw = DIRTY_ALL;
+    }
+    frames.update();
+    const Frame& frame = frames.front();
+    if (frame.sequence == 0) return; // nothing published yet
+    for (int i = 0; i < REGION_COUNT; ++i) {
+        if (frame.revision[i] != drawnRevision[i]) redraw |= 1u << i;
+    }
+    drawnRevision = frame.revision;
+    auto stat = [&](const char* name) {
+        auto it = frame.statistics.find(name);
+        return it == frame.statistics.end() ? 0 : it->second;
+    };
+
+    if (!layout.valid) computeLayout(frame);
+    if (!layout.fits) {
+        if ((redraw & DIRTY_STATIC) && layout.noticewin) UI::stage(layout.noticewin);
+        redraw = 0;
+        return;
+    }
+
+    Trace::Span span("render");
+    int64_t renderStart = Profiler::isEnabled() ? Profiler::now() : 0;
+
+    const int board_width = 10;
+    const int board_height = 20;
+    const int cell_width = 2;
+    const int box_width = 12;
+    const int box_height = 6;
+    const int piece_gap = -2;
+
+    auto now = std::chrono::steady_clock::now();
+
+    // slow links: colors and the ghost come and go with the level, so redraw everything
+    OutputMonitor::Level level = OutputMonitor::level();
+    if (level != renderedLevel) {
+        renderedLevel = level;
+        redraw = DIRTY_ALL;
+    }
+
+    // the hud ticks every tenth of a second, or once a second when the link is congested
+    bool slowHud = level >= OutputMonitor::SLOW_HUD;
+    int hudTick = static_cast<int>(slowHud ? frame.gameTime : frame.gameTime * 10);
+    if (hudTick != lastHudTick) {
+        lastHudTick = hudTick;
+        redraw |= DIRTY_STATS;
+    } else if (slowHud && !(redraw & DIRTY_STATIC)) {
+        redraw &= ~DIRTY_STATS;
+    }
+
+    // board window
+    if (redraw & DIRTY_BOARD) {
+        box(layout.boardwin, 0, 0);
+        UI::renderBoard(layout.boardwin, frame.board, frame.blockCharacter, board_height, board_width, cell_width);
+        if (frame.pieceVisible) {
+            if (level < OutputMonitor::NO_GHOST) {
+                UI::renderGhostPiece(layout.boardwin, frame.current, frame.board, cell_width);
+            }
+            UI::renderTetromino(layout.boardwin, frame.current, frame.blockCharacter, cell_width, false);
+        }
+        present(layout.boardwin);
+
+        // incoming garbage meter along the left edge of the board
+        if (layout.meterwin && frame.mode == "versus") {
+            for (int i = 0; i < board_height; ++i) {
+                wattrset(layout.meterwin, i < frame.pendingGarbage ? COLOR_PAIR(7) : A_NORMAL);
+                mvwaddch(layout.meterwin, board_height - 1 - i, 0, ' ');
+            }
+            wattrset(layout.meterwin, A_NORMAL);
+            present(layout.meterwin);
+        }
+    }
+
+    // gamemode title text
+    if ((redraw & DIRTY_STATIC) && layout.titlewin) {
+        int mode_x = std::max(0, (getmaxx(layout.titlewin) - (int)layout.title.size()) / 2);
+        werase(layout.titlewin);
+        mvwprintw(layout.titlewin, 0, mode_x, "%s", layout.title.c_str());
+        present(layout.titlewin);
+    }
+
+    // main stat, rewritten only when the text changes
+    if ((redraw & DIRTY_STATS) && layout.mainstatwin) {
+        char mainStat[sizeof(layout.shownStat)] = "";
+        switch (layout.mainStat) {
+            case STAT_LINES:
+                snprintf(mainStat, sizeof(mainStat), "Lines: %d", stat("lines"));
+                break;
+            case STAT_ATTACK:
+                snprintf(mainStat, sizeof(mainStat), "Attack: %d", stat("attack"));
+                break;
+            case STAT_FAULTS:
+                snprintf(mainStat, sizeof(mainStat), "Faults: %d", stat("finesseFaults"));
+                break;
+            case STAT_LINES_LEFT:
+                if (frame.paceKnown) {
+                    // pace against the personal best as of the last split
+                    snprintf(mainStat, sizeof(mainStat), "Lines: %d  PB %+.2f",
+                             std::max(0, layout.statTarget - stat("lines")), frame.paceDelta);
+                } else {
+                    snprintf(mainStat, sizeof(mainStat), "Lines: %d", std::max(0, layout.statTarget - stat("lines")));
+                }
+                break;
+            case STAT_TIME_LEFT:
+                snprintf(mainStat, sizeof(mainStat), "Time: %s",
+                         UI::formatSeconds(std::max(0.0, layout.statTimeLimit - frame.gameTime)).c_str());
+                break;
+            case STAT_CHEESE_LEFT:
+                snprintf(mainStat, sizeof(mainStat), "Cheese: %d", std::max(0, layout.statTarget - stat("cheeseCleared")));
+                break;
+            case STAT_UNDO:
+                snprintf(mainStat, sizeof(mainStat), "Undo %d  Redo %d", frame.undoDepth, frame.redoDepth);
+                break;
+            case STAT_LEVEL:
+                snprintf(mainStat, sizeof(mainStat), "Level %d  Lines %d/%d", GameUtils::levelForLines(stat("lines")),
+                         stat("lines"), layout.statTarget);
+                break;
+            case STAT_NONE:
+                break;
+        }
+        if ((redraw & DIRTY_STATIC) || strcmp(mainStat, layout.shownStat) != 0) {
+            memcpy(layout.shownStat, mainStat, sizeof(mainStat));
+            int attack_x = std::max(0, (getmaxx(layout.mainstatwin) - (int)strlen(mainStat)) / 2);
+            werase(layout.mainstatwin);
+            mvwprintw(layout.mainstatwin, 0, attack_x, "%s", mainStat);
+            present(layout.mainstatwin);
+        }
+    }
+
+    // output stats line, twice a second
+    if (layout.linkwin) {
+        int64_t nowMicros = std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch()).count();
+        bool shown = level > OutputMonitor::FULL || Profiler::isEnabled();
+        if ((redraw & DIRTY_STATIC) || nowMicros - lastLinkUpdate >= 500000) {
+            lastLinkUpdate = nowMicros;
+            static const char* LEVEL_TAGS[] = {"", " hud", " -ghost", " mono"};
+            char link[sizeof(layout.shownLink)] = "";
+            if (shown && OutputMonitor::bytesKnown()) {
+                snprintf(link, sizeof(link), "%.1f KB/s %.0f fps%s", OutputMonitor::bytesPerSecond() / 1024.0,
+                         OutputMonitor::framesPerSecond(), LEVEL_TAGS[level]);
+            } else if (shown) {
+                snprintf(link, sizeof(link), "q %d B %.0f fps%s", OutputMonitor::queuedBytes(),
+                         OutputMonitor::framesPerSecond(), LEVEL_TAGS[level]);
+            }
+            if ((redraw & DIRTY_STATIC) || strcmp(link, layout.shownLink) != 0) {
+                memcpy(layout.shownLink, link, sizeof(link));
+                int link_x = std::max(0, (getmaxx(layout.linkwin) - (int)strlen(link)) / 2);
+                werase(layout.linkwin);
+                wattron(layout.linkwin, A_DIM);
+                mvwprintw(layout.linkwin, 0, link_x, "%s", link);
+                wattroff(layout.linkwin, A_DIM);
+                present(layout.linkwin);
+            }
+        }
+    }
 
     // hold window
-    int hold_x = start_x - box_width - 2;
-    int hold_y = start_y;
-    WINDOW* holdwin = newwin(box_height, box_width, hold_y, hold_x);
-    box(holdwin, 0, 0);
-    mvwprintw(holdwin, 0, 2, "HOLD");
-    UI::renderPieceBox(holdwin, holdPiece, cell_width);
-    wrefresh(holdwin);
+    if ((redraw & DIRTY_HOLD) && layout.holdwin) {
+        werase(layout.holdwin);
+        box(layout.holdwin, 0, 0);
+        mvwprintw(layout.holdwin, 0, 2, "HOLD");
+        UI::renderPieceBox(layout.holdwin, frame.held, frame.blockCharacter, cell_width);
+        present(layout.holdwin);
+    }
 
     // stats window
-    int stats_height = 12;
-    int stats_width = box_width;
-    int stats_y = hold_y + box_height + 1;
-    int stats_x = hold_x;
-    WINDOW* statswin = newwin(stats_height, stats_width, stats_y, stats_x);
-
-    UI::renderStatsWindow(statswin, statistics, gameTime);
-    wrefresh(statswin);
+    if ((redraw & DIRTY_STATS) && layout.statswin) {
+        werase(layout.statswin);
+        UI::renderStatsWindow(layout.statswin, frame.statistics, frame.gameTime);
+        present(layout.statswin);
+        if (layout.rateswin) {
+            werase(layout.rateswin);
+            UI::renderRatesWindow(layout.rateswin, frame.rates);
+            present(layout.rateswin);
+        }
+    }
 
     // next window
-    int piece_gap = -2;
-    int next_x = start_x + win_width + 2;
-    int next_y = start_y;
-    int next_box_height = (box_height + piece_gap) * 4 + 2;
-    int next_box_width = box_width;
-    WINDOW* nextwin = newwin(next_box_height, next_box_width, next_y, next_x);
-    box(nextwin, 0, 0);
-    mvwprintw(nextwin, 0, 2, "NEXT");
-    for (int i = 0; i < 4 && i < (int)bag.size(); ++i) {
-        int piece_offset_y = 1 + i * (box_height + piece_gap);
-        WINDOW* temp = derwin(nextwin, box_height - 2, box_width - 2, piece_offset_y, 1);
-        UI::renderPieceBox(temp, bag[i], cell_width);
-        delwin(temp);
+    if ((redraw & DIRTY_NEXT) && layout.nextwin) {
+        werase(layout.nextwin);
+        box(layout.nextwin, 0, 0);
+        mvwprintw(layout.nextwin, 0, 2, "NEXT");
+        for (int i = 0; i < frame.nextCount; ++i) {
+            int piece_offset_y = 1 + i * (box_height + piece_gap);
+            WINDOW* temp = derwin(layout.nextwin, box_height - 2, box_width - 2, piece_offset_y, 1);
+            UI::renderPieceBox(temp, frame.next[i], frame.blockCharacter, cell_width);
+            delwin(temp);
+        }
+        present(layout.nextwin);
     }
-    wrefresh(nextwin);
 
     // handling window
-    int handling_height = 6;
-    int handling_width = box_width;
-    int handling_y = next_y + next_box_height + 1;
-    int handling_x = next_x;
-    WINDOW* handlingwin = newwin(handling_height, handling_width, handling_y, handling_x);
-    UI::renderHandling(handlingwin);
-    wrefresh(handlingwin);
-
-    // popup text
-    std::vector<std::string> lines;
-    size_t maxLen = 0;
-    size_t pos = 0, prev = 0;
-    while ((pos = popupText.find('\n', prev)) != std::string::npos) {
-        lines.emplace_back(popupText.substr(prev, pos - prev));
-        prev = pos + 1;
+    if ((redraw & DIRTY_STATIC) && layout.handlingwin) {
+        UI::renderHandling(layout.handlingwin, frame.arr, frame.das, frame.dcd, frame.sdf);
+        present(layout.handlingwin);
     }
-    lines.emplace_back(popupText.substr(prev));
-    for (const auto& l : lines) maxLen = std::max(maxLen, l.size());
 
-    int popup_y = stats_y + stats_height + 1;
-    int popup_x = start_x - (int)maxLen - 2;
-    if (!popupText.empty() && std::chrono::duration<double>(now - popupStartTime).count() < popupDurationSeconds) {
-        for (size_t i = 0; i < lines.size(); ++i) {
-            int line_x = popup_x + (int)(maxLen - lines[i].size());
-            mvprintw(popup_y + (int)i, line_x, "%s", lines[i].c_str());
+    // popup text, taken down by the renderer once its time is up
+    bool popupLive = !frame.popupLines.empty() &&
+                     std::chrono::duration<double>(now - frame.popupStartTime).count() < frame.popupDurationSeconds;
+    if (popupLive) {
+        if ((redraw & DIRTY_POPUP) && layout.popupwin) {
+            int popup_x = layout.popupWidth - (int)frame.popupMaxLen - 2;
+            werase(layout.popupwin);
+            for (size_t i = 0; i < frame.popupLines.size(); ++i) {
+                int line_x = popup_x + (int)(frame.popupMaxLen - frame.popupLines[i].size());
+                mvwprintw(layout.popupwin, (int)i, line_x, "%s", frame.popupLines[i].c_str());
+            }
+            present(layout.popupwin);
+            popupShown = true;
         }
-    } else {
-        for (size_t i = 0; i < lines.size(); ++i) {
-            std::string spaces(start_x, ' ');
-            mvprintw(popup_y + (int)i, 0, "%s", spaces.c_str());
+    } else if (popupShown) {
+        if (layout.popupwin) {
+            werase(layout.popupwin);
+            present(layout.popupwin);
         }
-        popupText.clear();
+        popupShown = false;
+    }
+
+    redraw = 0;
+
+    if (renderStart) {
+        Profiler::record(Profiler::RENDER, Profiler::now() - renderStart);
+        Profiler::renderOverlay();
     }
+}
+
+void Game::setViewport(int x, int width) {
+    viewportX = x;
+    viewportWidth = width;
+    relayoutRequested = true;
+    invalidate();
+}
+
+void Game::invalidate() {
+    redrawRequested = true;
+}
 
-    delwin(boardwin);
-    delwin(holdwin);
-    delwin(nextwin);
-    delwin(handlingwin);
-    delwin(statswin);
-}
\ No newline at end of file
+void Game::releaseWindows() {
+    for (WINDOW** win : {&layout.boardwin, &layout.holdwin, &layout.statswin, &layout.rateswin, &layout.nextwin,
+                          &layout.handlingwin, &layout.titlewin, &layout.mainstatwin, &layout.popupwin,
+                          &layout.meterwin, &layout.noticewin, &layout.linkwin}) {
+        if (*win) {
+            delwin(*win);
+            *win = nullptr;
+        }
+    }
+    layout.valid = false;
+}
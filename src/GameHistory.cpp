@@ -0,0 +1,201 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <sys/mman.h>
+
+#include "../include/GameHistory.h"
+#include "../include/RecordLog.h"
+#include "../include/Settings.h"
+#include "../include/SettingsStore.h"
+#include "../include/UI.h"
+
+static_assert(sizeof(GameHistory::Record) == 136, "game record layout changed");
+
+// Game's statistic names, in Record::counters order; names a mode never sets are stored as 0
+static const char* counterNames[GameHistory::COUNTER_COUNT] = {
+    "totalPieces", "attack", "lines", "single", "double", "triple", "tetris", "tspins", "tss", "tsd",
+    "tst", "tspin_minis", "pc", "max_b2bStreak", "max_combo", "score", "cheeseCleared",
+    "finessePieces", "finesseFaults", "finesseExtra"
+};
+
+const char* GameHistory::counterName(int index) {
+    return counterNames[index];
+}
+
+GameHistory::Summary GameHistory::summary{};
+bool GameHistory::loaded = false;
+
+std::string GameHistory::logPath() {
+    return Settings::getUserDataPath() + "games.bin";
+}
+
+std::string GameHistory::summaryPath() {
+    return Settings::getUserDataPath() + "games.idx";
+}
+
+static uint32_t recordChecksum(const GameHistory::Record& record) {
+    return SettingsStore::crc32(&record, offsetof(GameHistory::Record, checksum));
+}
+
+static uint32_t summaryChecksum(const GameHistory::Summary& summary) {
+    return SettingsStore::crc32(&summary, offsetof(GameHistory::Summary, checksum));
+}
+
+void GameHistory::fold(const Record& record) {
+    summary.games++;
+    summary.seconds += record.time;
+    for (int i = 0; i < COUNTER_COUNT; ++i) summary.counters[i] += record.counters[i];
+
+    ModeSummary* slot = nullptr;
+    for (ModeSummary& mode : summary.modes) {
+        if (mode.mode[0] != '\0' && std::strncmp(mode.mode, record.mode, sizeof(mode.mode)) == 0) {
+            slot = &mode;
+            break;
+        }
+    }
+    for (ModeSummary& mode : summary.modes) {
+        if (!slot && mode.mode[0] == '\0') {
+            slot = &mode;
+            std::memcpy(slot->mode, record.mode, sizeof(slot->mode));
+        }
+    }
+    if (!slot) return; // more modes than slots, the game only counts towards the totals
+    slot->games++;
+    slot->seconds += record.time;
+    if (record.completed && (slot->bestTime == 0.0 || record.time < slot->bestTime)) slot->bestTime = record.time;
+    slot->bestScore = std::max(slot->bestScore, record.counters[COUNTER_SCORE]);
+    slot->bestLines = std::max(slot->bestLines, record.counters[COUNTER_LINES]);
+    slot->bestPps = std::max(slot->bestPps, record.pps);
+    slot->bestApm = std::max(slot->bestApm, record.apm);
+}
+
+void GameHistory::foldLog(int fd, uint64_t size) {
+    uint64_t end = size - size % sizeof(Record); // a torn last record is cut off by the next append
+    if (end <= summary.coveredBytes) return;
+    void* map = mmap(nullptr, end, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) return;
+    madvise(map, end, MADV_SEQUENTIAL);
+    const Record* records = static_cast<const Record*>(map);
+    for (uint64_t i = summary.coveredBytes / sizeof(Record); i < end / sizeof(Record); ++i) {
+        if (records[i].checksum == recordChecksum(records[i])) fold(records[i]);
+    }
+    munmap(map, end);
+    summary.coveredBytes = end;
+}
+
+void GameHistory::load(bool rebuild) {
+    loaded = true;
+    summary = Summary{};
+    Summary stored;
+    if (!rebuild && RecordLog::loadCache(summaryPath(), &stored, sizeof(stored)) && stored.magic == MAGIC &&
+        stored.version == VERSION && stored.checksum == summaryChecksum(stored) &&
+        stored.coveredBytes % sizeof(Record) == 0) {
+        summary = stored;
+    }
+
+    // the shared lock keeps appends, and the truncation of a torn tail, away from the mapping
+    int fd = RecordLog::openLog(logPath(), false);
+    uint64_t size = fd >= 0 ? RecordLog::logSize(fd) : 0;
+    if (size < summary.coveredBytes) summary = Summary{}; // the log was replaced, refold it
+    uint64_t covered = summary.coveredBytes;
+    if (fd >= 0) {
+        foldLog(fd, size);
+        RecordLog::closeLog(fd);
+    }
+    if (summary.coveredBytes != covered || rebuild) saveSummary();
+}
+
+bool GameHistory::record(const std::string& mode, uint32_t seed, double time, bool completed,
+                         const std::unordered_map<std::string, int>& statistics) {
+    if (!loaded) load(false);
+
+    Record record{};
+    mode.copy(record.mode, sizeof(record.mode) - 1);
+    record.finishedAt = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    record.time = time;
+    record.seed = seed;
+    record.completed = completed;
+    for (int i = 0; i < COUNTER_COUNT; ++i) {
+        auto it = statistics.find(counterNames[i]);
+        record.counters[i] = it == statistics.end() ? 0 : it->second;
+    }
+    record.pps = time > 0 ? (float)(record.counters[COUNTER_PIECES] / time) : 0.0f;
+    record.apm = time > 0 ? (float)(record.counters[COUNTER_ATTACK] * 60.0 / time) : 0.0f;
+    record.checksum = recordChecksum(record);
+
+    int fd = RecordLog::openLog(logPath(), true);
+    if (fd < 0) return false;
+    // games another instance appended since load; the append then drops any torn tail
+    foldLog(fd, RecordLog::logSize(fd));
+    bool ok = RecordLog::append(fd, summary.coveredBytes, &record, sizeof(record));
+    RecordLog::closeLog(fd);
+    if (!ok) return false;
+
+    summary.coveredBytes += sizeof(Record);
+    fold(record);
+    return saveSummary();
+}
+
+bool GameHistory::saveSummary() {
+    summary.magic = MAGIC;
+    summary.version = VERSION;
+    summary.checksum = summaryChecksum(summary);
+
+    return RecordLog::saveCache(summaryPath(), &summary, sizeof(summary));
+}
+
+const GameHistory::Summary& GameHistory::totals() {
+    load(false);
+    return summary;
+}
+
+int GameHistory::report(int recent, const std::string& mode, bool rebuild) {
+    load(rebuild);
+
+    std::printf("%llu games, %.1f hours played\n", (unsigned long long)summary.games, summary.seconds / 3600.0);
+    std::printf("%lld pieces, %lld lines, %lld attack, %lld tetrises, %lld t-spins, %lld perfect clears\n\n",
+                (long long)summary.counters[COUNTER_PIECES], (long long)summary.counters[COUNTER_LINES],
+                (long long)summary.counters[COUNTER_ATTACK], (long long)summary.counters[COUNTER_TETRIS],
+                (long long)summary.counters[COUNTER_TSPINS], (long long)summary.counters[COUNTER_PC]);
+
+    std::printf("%-14s %7s %9s %11s %10s %6s %6s %7s\n",
+                "mode", "games", "hours", "best time", "best score", "lines", "pps", "apm");
+    for (const ModeSummary& m : summary.modes) {
+        if (m.mode[0] == '\0' || (!mode.empty() && mode != m.mode)) continue;
+        std::string best = m.bestTime > 0.0 ? UI::formatSeconds(m.bestTime) : "-";
+        std::printf("%-14.16s %7llu %9.2f %11s %10d %6d %6.2f %7.2f\n", m.mode, (unsigned long long)m.games,
+                    m.seconds / 3600.0, best.c_str(), m.bestScore, m.bestLines, m.bestPps, m.bestApm);
+    }
+    if (recent <= 0) return 0;
+
+    // newest first straight from the mapped log, only as far back as needed; the shared lock
+    // is held until the mapping is gone, so no torn tail is cut off underneath it
+    std::printf("\n%-19s %-14s %11s %6s %10s %6s %7s\n", "finished", "mode", "time", "lines", "score", "pps", "apm");
+    int fd = RecordLog::openLog(logPath(), false);
+    if (fd < 0) return 0;
+    uint64_t count = RecordLog::logSize(fd) / sizeof(Record);
+    void* map = count > 0 ? mmap(nullptr, count * sizeof(Record), PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    if (map == MAP_FAILED) {
+        RecordLog::closeLog(fd);
+        return count > 0 ? 1 : 0;
+    }
+    const Record* records = static_cast<const Record*>(map);
+    int shown = 0;
+    for (uint64_t i = count; i-- > 0 && shown < recent;) {
+        const Record& r = records[i];
+        if (r.checksum != recordChecksum(r) || (!mode.empty() && std::strncmp(mode.c_str(), r.mode, sizeof(r.mode)) != 0)) continue;
+        char when[20];
+        std::time_t seconds = (std::time_t)(r.finishedAt / 1000);
+        std::strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", std::localtime(&seconds));
+        std::printf("%-19s %-14.16s %11s %6d %10d %6.2f %7.2f%s\n", when, r.mode, UI::formatSeconds(r.time).c_str(),
+                    r.counters[COUNTER_LINES], r.counters[COUNTER_SCORE], r.pps, r.apm, r.completed ? "" : "  (unfinished)");
+        shown++;
+    }
+    munmap(map, count * sizeof(Record));
+    RecordLog::closeLog(fd);
+    return 0;
+}
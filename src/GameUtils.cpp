@@ -1,20 +1,19 @@
 #include <vector>
 #include <algorithm>
+#include <cmath>
 #include <random>
 #include <fstream>
 
 #include "../include/GameUtils.h"
 #include "../include/Tetromino.h"
 
-std::vector<Tetromino> GameUtils::generateBag() {
+std::vector<Tetromino> GameUtils::generateBag(std::mt19937& rng) {
     std::vector<Tetromino> bag = {
         Tetromino('I'), Tetromino('J'), Tetromino('L'),
         Tetromino('O'), Tetromino('S'), Tetromino('Z'),
         Tetromino('T')
     };
-    std::random_device rd;
-    std::mt19937 g(rd());
-    std::shuffle(bag.begin(), bag.end(), g);
+    std::shuffle(bag.begin(), bag.end(), rng);
     return bag;
 }
 
@@ -227,3 +226,24 @@ void GameUtils::generateCheeseLines(std::vector<std::vector<int>>& board, int nu
     }
     board.insert(board.end(), cheeseRows.begin(), cheeseRows.end());
 }
+
+void GameUtils::generateGarbageLines(std::vector<std::vector<int>>& board, int num) {
+    static thread_local std::mt19937 gen(std::random_device{}());
+    std::uniform_int_distribution<> dist(0, 9);
+
+    // one hole column shared by the whole chunk of received garbage
+    int hole = dist(gen);
+    std::vector<int> row(10, 8);
+    row[hole] = 0;
+    for (int i = 0; i < num; ++i) {
+        board.erase(board.begin());
+    }
+    board.insert(board.end(), num, row);
+}
+
+double GameUtils::levelGravity(int level) {
+    // from level 20 on the curve is past 20G anyway
+    level = std::max(1, std::min(level, 20));
+    double secondsPerRow = std::pow(0.8 - (level - 1) * 0.007, level - 1);
+    return std::min(INSTANT_GRAVITY, 1.0 / (secondsPerRow * 1000.0));
+}
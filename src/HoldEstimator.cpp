@@ -0,0 +1,68 @@
+#include <algorithm>
+
+#include "../include/HoldEstimator.h"
+
+static const double SLACK_MS = 10.0; // scheduling jitter between the terminal and the input thread
+
+void HoldEstimator::configure(float repeatDelayMs, float repeatIntervalMs) {
+    delayMs = repeatDelayMs;
+    intervalMs = repeatIntervalMs;
+}
+
+void HoldEstimator::track(int key) {
+    for (const auto& k : keys) {
+        if (k.code == key) return;
+    }
+    Key tracked;
+    tracked.code = key;
+    keys.push_back(tracked);
+}
+
+void HoldEstimator::reset() {
+    for (auto& k : keys) {
+        k.down = false;
+        k.repeats = 0;
+    }
+}
+
+double HoldEstimator::tolerance(const Key& key) const {
+    // the first repeat wanders more than the steady rate does
+    return key.repeats == 0 ? std::max(30.0, delayMs * 0.3) : std::max(12.0, intervalMs * 0.5);
+}
+
+void HoldEstimator::process(const std::vector<InputEvent>& in, std::vector<InputEvent>& out,
+                            std::chrono::steady_clock::time_point now) {
+    for (const auto& event : in) {
+        auto it = std::find_if(keys.begin(), keys.end(), [&](const Key& k) { return k.code == event.key; });
+        if (it == keys.end()) {
+            out.push_back(event);
+            continue;
+        }
+        Key& key = *it;
+        if (key.down) {
+            double gap = std::chrono::duration<double, std::milli>(event.time - key.lastSeen).count();
+            double expected = expectedGap(key);
+            if (gap >= expected - tolerance(key) && gap <= expected + tolerance(key) + SLACK_MS) {
+                key.repeats++;
+                key.lastSeen = event.time;
+                out.push_back({event.key, event.time, InputEvent::REPEAT});
+                continue;
+            }
+            // off schedule, so this is the player tapping again
+            out.push_back({event.key, event.time, InputEvent::RELEASE});
+        }
+        key.down = true;
+        key.repeats = 0;
+        key.lastSeen = event.time;
+        out.push_back({event.key, event.time, InputEvent::PRESS});
+    }
+
+    for (auto& key : keys) {
+        if (!key.down) continue;
+        double silent = std::chrono::duration<double, std::milli>(now - key.lastSeen).count();
+        if (silent > expectedGap(key) + tolerance(key) + SLACK_MS) {
+            key.down = false;
+            out.push_back({key.code, now, InputEvent::RELEASE});
+        }
+    }
+}
@@ -0,0 +1,274 @@
+#include <curses.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <csignal>
+#include <cstring>
+
+#include "../include/InputReader.h"
+
+SpscQueue<InputEvent, 256> InputReader::queue;
+std::thread InputReader::reader;
+std::atomic<bool> InputReader::running{false};
+bool InputReader::protocolAllowed = true;
+std::atomic<bool> InputReader::protocolAnswered{false};
+std::atomic<bool> InputReader::enhanced{false};
+std::atomic<bool> InputReader::syncOutput{false};
+std::atomic<bool> InputReader::resized{false};
+std::mutex InputReader::wakeMutex;
+std::condition_variable InputReader::wake;
+bool InputReader::keyPending = false;
+
+static const int ESCAPE_DELAY_MS = 25; // a lone ESC is a key once nothing follows it for this long
+static const int IDLE_POLL_MS = 50;    // how often the thread wakes to check for stop and resize
+
+// kitty protocol flags: disambiguate (1), report event types (2), all keys as escape codes (8)
+static const char KITTY_QUERY[] = "\x1b[?u\x1b[c"; // flags query, then primary attributes as a fence
+static const char KITTY_PUSH[] = "\x1b[>11u";
+static const char KITTY_POP[] = "\x1b[<u";
+static const char SYNC_QUERY[] = "\x1b[?2026$p"; // DECRQM for synchronized output
+
+static void writeTerminal(const char* sequence) {
+    ssize_t ignored = write(STDOUT_FILENO, sequence, std::strlen(sequence));
+    (void)ignored;
+}
+
+void InputReader::start() {
+    if (running) return;
+    InputEvent stale;
+    while (queue.pop(stale)) {}
+    // curses would otherwise peek at stdin to cut refreshes short while we own it
+    typeahead(-1);
+    running = true;
+    reader = std::thread(readLoop);
+    if (!syncOutput) writeTerminal(SYNC_QUERY);
+    if (protocolAllowed) writeTerminal(KITTY_QUERY);
+}
+
+void InputReader::stop() {
+    if (!running) return;
+    if (enhanced) {
+        writeTerminal(KITTY_POP);
+        enhanced = false;
+        // let the reader swallow release events still in flight for the old mode
+        std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    }
+    protocolAnswered = false;
+    running = false;
+    if (reader.joinable()) reader.join();
+    flushinp();
+    typeahead(STDIN_FILENO);
+}
+
+void InputReader::restoreTerminal() {
+    if (enhanced.load(std::memory_order_relaxed)) {
+        writeTerminal(KITTY_POP);
+    }
+}
+
+void InputReader::drain(std::vector<InputEvent>& out) {
+    InputEvent event;
+    while (queue.pop(event)) out.push_back(event);
+}
+
+void InputReader::waitForInput(std::chrono::steady_clock::time_point deadline) {
+    // a key pushed after the last drain leaves keyPending set, so it is never slept through
+    std::unique_lock<std::mutex> lock(wakeMutex);
+    wake.wait_until(lock, deadline, [] { return keyPending; });
+    keyPending = false;
+}
+
+bool InputReader::applyTerminalChanges() {
+    // the terminal answered the query; switch modes between frames so the sequence never
+    // lands in the middle of one
+    if (protocolAnswered.exchange(false) && running && !enhanced) {
+        writeTerminal(KITTY_PUSH);
+        enhanced = true;
+    }
+
+    if (!resized.exchange(false)) return false;
+    struct winsize size;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0) {
+        resizeterm(size.ws_row, size.ws_col);
+    }
+    return true;
+}
+
+void InputReader::push(int key, InputEvent::Type type, std::chrono::steady_clock::time_point time) {
+    // a full queue means the game loop stalled for hundreds of keys, dropping is fine
+    queue.push({key, time, type});
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        keyPending = true;
+    }
+    wake.notify_one();
+}
+
+void InputReader::readLoop() {
+    unsigned char buffer[256];
+    size_t used = 0;
+    struct winsize lastSize = {};
+    ioctl(STDOUT_FILENO, TIOCGWINSZ, &lastSize);
+
+    while (running.load(std::memory_order_relaxed)) {
+        struct pollfd pfd = {STDIN_FILENO, POLLIN, 0};
+        int ready = poll(&pfd, 1, used > 0 ? ESCAPE_DELAY_MS : IDLE_POLL_MS);
+        auto now = std::chrono::steady_clock::now();
+        if (ready > 0) {
+            ssize_t n = read(STDIN_FILENO, buffer + used, sizeof(buffer) - used);
+            if (n > 0) used += n;
+        }
+
+        // an incomplete escape sequence is only flushed once the terminal goes quiet
+        bool more = ready > 0;
+        size_t offset = 0;
+        while (offset < used) {
+            int key = -1;
+            InputEvent::Type type = InputEvent::PRESS;
+            size_t consumed = decode(buffer + offset, used - offset, more, key, type);
+            if (consumed == 0) break;
+            if (key >= 0) push(key, type, now);
+            offset += consumed;
+        }
+        std::memmove(buffer, buffer + offset, used - offset);
+        used -= offset;
+        if (used == sizeof(buffer)) used = 0;
+
+        struct winsize size;
+        if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0 &&
+            (size.ws_row != lastSize.ws_row || size.ws_col != lastSize.ws_col)) {
+            lastSize = size;
+            resized = true; // before the event, so whoever sees the key can resize
+            push(KEY_RESIZE, InputEvent::PRESS, now);
+        }
+    }
+}
+
+// returns the bytes used for one key (0 = wait for more), key is -1 for sequences we ignore
+size_t InputReader::decode(const unsigned char* bytes, size_t length, bool more, int& key, InputEvent::Type& type) {
+    unsigned char c = bytes[0];
+    if (c != 27) {
+        if (c == '\r') key = '\n';
+        else if (c == 127) key = KEY_BACKSPACE;
+        else key = c;
+        return 1;
+    }
+    if (length < 3 && (length == 1 || bytes[1] == '[' || bytes[1] == 'O')) {
+        if (more) return 0;
+        key = 27;
+        return 1;
+    }
+
+    if (bytes[1] == 'O') {
+        // ss3 sequences, sent for arrows in keypad mode and for F1-F4
+        switch (bytes[2]) {
+            case 'A': key = KEY_UP; break;
+            case 'B': key = KEY_DOWN; break;
+            case 'C': key = KEY_RIGHT; break;
+            case 'D': key = KEY_LEFT; break;
+            case 'H': key = KEY_HOME; break;
+            case 'F': key = KEY_END; break;
+            case 'P': case 'Q': case 'R': case 'S': key = KEY_F(1 + bytes[2] - 'P'); break;
+            default: key = -1;
+        }
+        return 3;
+    }
+
+    if (bytes[1] == '[') {
+        // csi: parameter bytes, intermediate bytes, then one final byte
+        // parameters are code[:alternates];modifiers[:event], only those two fields matter here
+        size_t i = 2;
+        bool privateReply = i < length && bytes[i] == '?';
+        int field = 0, sub = 0;
+        int values[2][2] = {{0, 0}, {0, 0}};
+        bool present[2][2] = {{false, false}, {false, false}};
+        while (i < length && bytes[i] >= 0x30 && bytes[i] <= 0x3F) {
+            unsigned char b = bytes[i];
+            if (b == ';') { field++; sub = 0; }
+            else if (b == ':') sub++;
+            else if (b >= '0' && b <= '9' && field < 2 && sub < 2) {
+                values[field][sub] = values[field][sub] * 10 + (b - '0');
+                present[field][sub] = true;
+            }
+            ++i;
+        }
+        int code = values[0][0];
+        int modifiers = present[1][0] ? values[1][0] : 1;
+        int event = present[1][1] ? values[1][1] : 1;
+        while (i < length && bytes[i] >= 0x20 && bytes[i] <= 0x2F) ++i;
+        if (i >= length) {
+            if (more) return 0;
+            key = -1;
+            return length;
+        }
+        unsigned char final = bytes[i];
+        key = -1;
+        if (event == 2) type = InputEvent::REPEAT;
+        else if (event == 3) type = InputEvent::RELEASE;
+
+        if (privateReply) {
+            // CSI ? flags u is the answer to the protocol query, CSI ? ... c the attributes fence
+            if (final == 'u') protocolAnswered = true;
+            // CSI ? 2026 ; state $ y, states 1-3 mean the mode is known (set, reset, always set)
+            if (final == 'y' && code == 2026 && values[1][0] >= 1 && values[1][0] <= 3) syncOutput = true;
+            return i + 1;
+        }
+        switch (final) {
+            case 'A': key = KEY_UP; break;
+            case 'B': key = KEY_DOWN; break;
+            case 'C': key = KEY_RIGHT; break;
+            case 'D': key = KEY_LEFT; break;
+            case 'H': key = KEY_HOME; break;
+            case 'F': key = KEY_END; break;
+            case 'P': case 'Q': case 'R': case 'S': key = KEY_F(1 + final - 'P'); break;
+            case 'u': key = decodeKittyKey(code, modifiers); break;
+            case '~':
+                switch (code) {
+                    case 1: case 7: key = KEY_HOME; break;
+                    case 2: key = KEY_IC; break;
+                    case 3: key = KEY_DC; break;
+                    case 4: case 8: key = KEY_END; break;
+                    case 5: key = KEY_PPAGE; break;
+                    case 6: key = KEY_NPAGE; break;
+                    case 11: case 12: case 13: case 14: key = KEY_F(code - 10); break;
+                    case 15: key = KEY_F(5); break;
+                    case 17: case 18: case 19: case 20: case 21: key = KEY_F(code - 11); break;
+                    case 23: case 24: key = KEY_F(code - 12); break;
+                }
+                break;
+        }
+        // the protocol reports ctrl+c as a key instead of letting the tty raise SIGINT
+        if (key == 3 && type == InputEvent::PRESS) {
+            std::raise(SIGINT);
+        }
+        return i + 1;
+    }
+
+    // alt+key arrives as ESC followed by the key, report both like curses does
+    key = 27;
+    return 1;
+}
+
+// maps a kitty CSI u key code to what curses getch would have returned
+int InputReader::decodeKittyKey(int code, int modifiers) {
+    int mods = modifiers > 0 ? modifiers - 1 : 0;
+    bool shift = mods & 1;
+    bool ctrl = mods & 4;
+    switch (code) {
+        case 13: return '\n';
+        case 9: return '\t';
+        case 27: return 27;
+        case 8: case 127: return KEY_BACKSPACE;
+        case 57417: return KEY_LEFT; // keypad arrows
+        case 57418: return KEY_RIGHT;
+        case 57419: return KEY_UP;
+        case 57420: return KEY_DOWN;
+    }
+    if (code >= 'a' && code <= 'z') {
+        if (ctrl) return code & 0x1f;
+        return shift ? code - 'a' + 'A' : code;
+    }
+    // modifier keys and the rest of the private use area have no curses equivalent
+    if (code < 32 || code > 126) return -1;
+    return code;
+}
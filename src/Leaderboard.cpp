@@ -0,0 +1,114 @@
+#include <cstddef>
+#include <cstring>
+#include <unistd.h>
+
+#include "../include/Leaderboard.h"
+#include "../include/RecordLog.h"
+#include "../include/Settings.h"
+#include "../include/SettingsStore.h"
+
+static_assert(sizeof(Leaderboard::Run) == 120, "run record layout changed");
+
+Leaderboard::Index Leaderboard::index{};
+
+std::string Leaderboard::logPath() {
+    return Settings::getUserDataPath() + "runs.bin";
+}
+
+std::string Leaderboard::indexPath() {
+    return Settings::getUserDataPath() + "runs.idx";
+}
+
+uint32_t Leaderboard::runChecksum(const Run& run) {
+    return SettingsStore::crc32(&run, offsetof(Run, checksum));
+}
+
+static uint32_t indexChecksum(const Leaderboard::Index& index) {
+    return SettingsStore::crc32(&index, offsetof(Leaderboard::Index, checksum));
+}
+
+bool Leaderboard::consider(const Run& run) {
+    index.runCount++;
+    // the mode's own slot, or else the first free one
+    Run* slot = nullptr;
+    for (Run& best : index.best) {
+        if (best.mode[0] != '\0' && std::strncmp(best.mode, run.mode, sizeof(best.mode)) == 0) {
+            slot = &best;
+            break;
+        }
+    }
+    for (Run& best : index.best) {
+        if (!slot && best.mode[0] == '\0') slot = &best;
+    }
+    if (!slot) return false; // more modes than slots, the run stays in the log only
+    if (slot->mode[0] != '\0' && slot->time <= run.time) return false;
+    *slot = run;
+    return true;
+}
+
+void Leaderboard::scan(int fd, uint64_t from, uint64_t to) {
+    // only whole records; a torn record left by a crash mid-append is cut off by the next record()
+    if (lseek(fd, (off_t)from, SEEK_SET) < 0) return;
+    Run run;
+    for (uint64_t at = from; at + sizeof(Run) <= to; at += sizeof(Run)) {
+        if (!RecordLog::readAll(fd, &run, sizeof(run))) break;
+        if (run.checksum == runChecksum(run) && run.splitCount <= (uint32_t)MAX_SPLITS) consider(run);
+        index.coveredBytes = at + sizeof(Run);
+    }
+}
+
+void Leaderboard::load() {
+    index = Index{};
+    Index stored;
+    if (RecordLog::loadCache(indexPath(), &stored, sizeof(stored)) && stored.magic == MAGIC &&
+        stored.version == VERSION && stored.checksum == indexChecksum(stored)) {
+        index = stored;
+    }
+
+    int fd = RecordLog::openLog(logPath(), false);
+    if (fd < 0) {
+        index = Index{}; // no log, nothing the index could refer to
+        return;
+    }
+    uint64_t size = RecordLog::logSize(fd);
+    if (size < index.coveredBytes) index = Index{}; // the log was replaced, start over
+    uint64_t covered = index.coveredBytes;
+    scan(fd, covered, size);
+    RecordLog::closeLog(fd);
+    if (index.coveredBytes != covered) saveIndex();
+}
+
+const Leaderboard::Run* Leaderboard::personalBest(const std::string& mode) {
+    for (const Run& best : index.best) {
+        if (best.mode[0] != '\0' && std::strncmp(best.mode, mode.c_str(), sizeof(best.mode)) == 0) return &best;
+    }
+    return nullptr;
+}
+
+bool Leaderboard::record(Run run) {
+    run.mode[sizeof(run.mode) - 1] = '\0';
+    run.checksum = runChecksum(run);
+
+    int fd = RecordLog::openLog(logPath(), true);
+    if (fd < 0) return false;
+    // runs another instance appended since load; the append then drops any torn tail
+    uint64_t size = RecordLog::logSize(fd);
+    if (size > index.coveredBytes) scan(fd, index.coveredBytes, size);
+    bool ok = RecordLog::append(fd, index.coveredBytes, &run, sizeof(run));
+    RecordLog::closeLog(fd);
+    if (!ok) return false;
+
+    index.coveredBytes += sizeof(Run);
+    bool best = consider(run);
+    saveIndex();
+    return best;
+}
+
+bool Leaderboard::saveIndex() {
+    index.magic = MAGIC;
+    index.version = VERSION;
+    index.checksum = indexChecksum(index);
+
+    // the index is only a cache of the log, a lost update is redone by the next load
+    return RecordLog::saveCache(indexPath(), &index, sizeof(index));
+}
@@ -17,7 +17,11 @@ static std::vector<std::vector<std::pair<std::string, std::string>>> menu_option
         {"2", "Blitz"},
         {"3", "Zen"},
         {"4", "Cheese"},
-        {"5", "Settings"},
+        {"5", "Versus"},
+        {"6", "Finesse"},
+        {"7", "Practice"},
+        {"8", "Marathon"},
+        {"9", "Settings"},
         {"q", "Exit"}
     },
     {
@@ -37,6 +41,18 @@ static std::vector<std::vector<std::pair<std::string, std::string>>> menu_option
         {"2", "18L Cheese"},
         {"3", "100L Cheese"},
         {"q", "Back to Main Menu"}
+    },
+    {
+        {"1", "vs Bot (Easy)"},
+        {"2", "vs Bot (Hard)"},
+        {"3", "Bot vs Bot"},
+        {"4", "Battle Royale (32 Bots)"},
+        {"q", "Back to Main Menu"}
+    },
+    {
+        {"1", "150L Marathon"},
+        {"2", "Master (20G)"},
+        {"q", "Back to Main Menu"}
     }
 };
 
@@ -45,6 +61,8 @@ static std::vector<std::string> titles = {
     "SPRINT MODE",
     "BLITZ MODE",
     "CHEESE MODE",
+    "VERSUS MODE",
+    "MARATHON MODE",
 };
 #else
 // macOS/Windows version with emojis
@@ -54,7 +72,11 @@ static std::vector<std::vector<std::pair<std::string, std::string>>> menu_option
         {"2", "🔥 Blitz"},
         {"3", "🧘 Zen"},
         {"4", "🧀 Cheese"},
-        {"5", "⚙️  Settings"},
+        {"5", "🤖 Versus"},
+        {"6", "🎯 Finesse"},
+        {"7", "↩️  Practice"},
+        {"8", "🏃 Marathon"},
+        {"9", "⚙️  Settings"},
         {"q", "←  Exit"}
     },
     {
@@ -74,6 +96,18 @@ static std::vector<std::vector<std::pair<std::string, std::string>>> menu_option
         {"2", "🧀 18L Cheese"},
         {"3", "🧀 100L Cheese"},
         {"q", "←  Back to Main Menu"}
+    },
+    {
+        {"1", "🤖 vs Bot (Easy)"},
+        {"2", "🤖 vs Bot (Hard)"},
+        {"3", "🤖 Bot vs Bot"},
+        {"4", "👑 Battle Royale (32 Bots)"},
+        {"q", "←  Back to Main Menu"}
+    },
+    {
+        {"1", "🏃 150L Marathon"},
+        {"2", "⚡ Master (20G)"},
+        {"q", "←  Back to Main Menu"}
     }
 };
 
@@ -82,6 +116,8 @@ static std::vector<std::string> titles = {
     "🚀 SPRINT MODE",
     "🔥 BLITZ MODE",
     "🧀 CHEESE MODE",
+    "🤖 VERSUS MODE",
+    "🏃 MARATHON MODE",
 };
 #endif
 
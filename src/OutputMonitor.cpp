@@ -0,0 +1,72 @@
+#include <chrono>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include "../include/OutputMonitor.h"
+
+bool OutputMonitor::adaptive = true;
+OutputMonitor::Level OutputMonitor::current = OutputMonitor::FULL;
+int OutputMonitor::queued = 0;
+int64_t OutputMonitor::windowStart = 0;
+int64_t OutputMonitor::windowBytes = 0;
+int64_t OutputMonitor::windowFrames = 0;
+double OutputMonitor::rateBytes = 0.0;
+double OutputMonitor::rateFrames = 0.0;
+bool OutputMonitor::countedBytes = false;
+int64_t OutputMonitor::lastChange = 0;
+int64_t OutputMonitor::congestedSince = 0;
+int64_t OutputMonitor::clearSince = 0;
+
+static const int QUEUE_LIMIT = 2048;           // bytes still waiting in the tty after a frame
+static const int64_t BLOCKED_MICROS = 8000;    // a flush this slow means write() had to wait
+static const int64_t STEP_UP_MICROS = 250000;  // sustained congestion before degrading further
+static const int64_t STEP_DOWN_MICROS = 3000000; // calm needed before restoring a level
+static const int64_t MIN_STEP_MICROS = 500000;
+
+static int64_t micros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void OutputMonitor::frameWritten(size_t bytes, int64_t flushMicros) {
+    int64_t now = micros();
+    int pending = 0;
+#ifdef TIOCOUTQ
+    if (ioctl(STDOUT_FILENO, TIOCOUTQ, &pending) != 0) pending = 0;
+#endif
+    queued = pending;
+
+    if (windowStart == 0) windowStart = now;
+    windowBytes += (int64_t)bytes;
+    windowFrames++;
+    if (bytes > 0) countedBytes = true;
+    if (now - windowStart >= 1000000) {
+        double seconds = (now - windowStart) / 1e6;
+        rateBytes = windowBytes / seconds;
+        rateFrames = windowFrames / seconds;
+        windowStart = now;
+        windowBytes = 0;
+        windowFrames = 0;
+    }
+
+    if (!adaptive) return;
+    bool congested = pending > QUEUE_LIMIT || flushMicros > BLOCKED_MICROS;
+    if (congested) {
+        clearSince = 0;
+        // a write that blocked counts as congestion for as long as it was stuck
+        if (congestedSince == 0) congestedSince = now - (flushMicros > BLOCKED_MICROS ? flushMicros : 0);
+        if (current < MONOCHROME && now - congestedSince >= STEP_UP_MICROS && now - lastChange >= MIN_STEP_MICROS) {
+            current = static_cast<Level>(current + 1);
+            lastChange = now;
+            congestedSince = now;
+        }
+    } else {
+        congestedSince = 0;
+        if (clearSince == 0) clearSince = now;
+        if (current > FULL && now - clearSince >= STEP_DOWN_MICROS && now - lastChange >= MIN_STEP_MICROS) {
+            current = static_cast<Level>(current - 1);
+            lastChange = now;
+            clearSince = now;
+        }
+    }
+}
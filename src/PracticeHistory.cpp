@@ -0,0 +1,31 @@
+#include "../include/PracticeHistory.h"
+
+void PracticeHistory::clear() {
+    oldest = 0;
+    count = 0;
+    cursor = -1;
+}
+
+void PracticeHistory::push(const State& state) {
+    if (ring.empty()) ring.resize(CAPACITY);
+    count = cursor + 1;
+    if (count == CAPACITY) {
+        oldest = (oldest + 1) % CAPACITY;
+        count--;
+    }
+    ring[(oldest + count) % CAPACITY] = state;
+    count++;
+    cursor = count - 1;
+}
+
+const PracticeHistory::State* PracticeHistory::undo() {
+    if (cursor <= 0) return nullptr;
+    cursor--;
+    return &at(cursor);
+}
+
+const PracticeHistory::State* PracticeHistory::redo() {
+    if (cursor >= count - 1) return nullptr;
+    cursor++;
+    return &at(cursor);
+}
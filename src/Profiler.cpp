@@ -0,0 +1,154 @@
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+#include "../include/Profiler.h"
+#include "../include/UI.h"
+
+Profiler::Histogram Profiler::histograms[Profiler::METRIC_COUNT];
+std::atomic<bool> Profiler::recording{false};
+std::atomic<bool> Profiler::overlay{false};
+std::string Profiler::reportPath = "clitris-profile.txt";
+WINDOW* Profiler::overlayWin = nullptr;
+int64_t Profiler::lastOverlayDraw = 0;
+
+static const char* METRIC_NAMES[] = {"update", "render", "output", "input", "frame", "bytes"};
+
+int Profiler::bucketFor(int64_t micros) {
+    if (micros < 0) micros = 0;
+    if (micros < LINEAR_BUCKETS) return (int)micros;
+    int exponent = 63 - __builtin_clzll((unsigned long long)micros);
+    int sub = (int)((micros >> (exponent - 4)) & (SUB_BUCKETS - 1));
+    int bucket = LINEAR_BUCKETS + (exponent - 5) * SUB_BUCKETS + sub;
+    return bucket < BUCKET_COUNT ? bucket : BUCKET_COUNT - 1;
+}
+
+int64_t Profiler::bucketValue(int bucket) {
+    if (bucket < LINEAR_BUCKETS) return bucket;
+    int exponent = (bucket - LINEAR_BUCKETS) / SUB_BUCKETS + 5;
+    int sub = (bucket - LINEAR_BUCKETS) % SUB_BUCKETS;
+    int64_t width = (int64_t)1 << (exponent - 4);
+    return (SUB_BUCKETS + sub) * width + width / 2;
+}
+
+void Profiler::record(Metric metric, int64_t micros) {
+    Histogram& h = histograms[metric];
+    h.counts[bucketFor(micros)].fetch_add(1, std::memory_order_relaxed);
+    h.total.fetch_add(1, std::memory_order_relaxed);
+    h.sum.fetch_add(micros, std::memory_order_relaxed);
+    int64_t seen = h.maximum.load(std::memory_order_relaxed);
+    while (micros > seen && !h.maximum.compare_exchange_weak(seen, micros, std::memory_order_relaxed)) {
+    }
+}
+
+int64_t Profiler::percentile(Metric metric, double p) {
+    const Histogram& h = histograms[metric];
+    uint64_t total = h.total.load(std::memory_order_relaxed);
+    if (total == 0) return 0;
+    uint64_t rank = (uint64_t)(p * (total - 1)) + 1;
+    uint64_t seen = 0;
+    for (int b = 0; b < BUCKET_COUNT; ++b) {
+        seen += h.counts[b].load(std::memory_order_relaxed);
+        if (seen >= rank) return std::min(bucketValue(b), max(metric));
+    }
+    return max(metric);
+}
+
+int64_t Profiler::max(Metric metric) {
+    return histograms[metric].maximum.load(std::memory_order_relaxed);
+}
+
+uint64_t Profiler::samples(Metric metric) {
+    return histograms[metric].total.load(std::memory_order_relaxed);
+}
+
+void Profiler::clear() {
+    for (auto& h : histograms) {
+        for (auto& count : h.counts) count.store(0, std::memory_order_relaxed);
+        h.total.store(0, std::memory_order_relaxed);
+        h.sum.store(0, std::memory_order_relaxed);
+        h.maximum.store(0, std::memory_order_relaxed);
+    }
+}
+
+void Profiler::toggleOverlay() {
+    overlay = !overlay; // the drawing side picks this up, it may be another thread
+}
+
+void Profiler::inputApplied(std::chrono::steady_clock::time_point arrival) {
+    record(INPUT_LATENCY, std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - arrival).count());
+}
+
+void Profiler::renderOverlay() {
+    if (!overlay) return;
+    if (!overlayWin) {
+        overlayWin = newwin(METRIC_COUNT + 3, 38, 0, 0);
+        lastOverlayDraw = 0;
+    }
+    if (!overlayWin) return;
+
+    // the numbers change a few times a second; in between only restore what the game drew over
+    int64_t current = now();
+    if (current - lastOverlayDraw < 250000) {
+        touchwin(overlayWin);
+        UI::stage(overlayWin);
+        return;
+    }
+    lastOverlayDraw = current;
+
+    werase(overlayWin);
+    box(overlayWin, 0, 0);
+    mvwprintw(overlayWin, 0, 2, "PROFILE [F3]");
+    mvwprintw(overlayWin, 1, 1, "%-7s %8s %8s %8s", "ms", "p50", "p99", "max");
+    for (int m = 0; m < METRIC_COUNT; ++m) {
+        Metric metric = static_cast<Metric>(m);
+        if (metric == BYTES) {
+            mvwprintw(overlayWin, m + 2, 1, "%-7s %8lld %8lld %8lld", METRIC_NAMES[m],
+                      (long long)percentile(metric, 0.50),
+                      (long long)percentile(metric, 0.99),
+                      (long long)max(metric));
+            continue;
+        }
+        mvwprintw(overlayWin, m + 2, 1, "%-7s %8.2f %8.2f %8.2f", METRIC_NAMES[m],
+                  percentile(metric, 0.50) / 1000.0,
+                  percentile(metric, 0.99) / 1000.0,
+                  max(metric) / 1000.0);
+    }
+    int64_t frame = percentile(FRAME, 0.50);
+    mvwprintw(overlayWin, METRIC_COUNT + 2, 2, " %.1f FPS ", frame > 0 ? 1e6 / frame : 0.0);
+    UI::stage(overlayWin);
+}
+
+void Profiler::hideOverlay() {
+    if (overlayWin) {
+        // goes out with the next frame, which the caller makes redraw what was underneath
+        werase(overlayWin);
+        UI::stage(overlayWin);
+        delwin(overlayWin);
+        overlayWin = nullptr;
+    }
+}
+
+void Profiler::writeReport() {
+    if (!recording) return;
+    std::ofstream file(reportPath);
+    if (!file) return;
+
+    file << "clitris profile (microseconds, bytes for the bytes row), renderer " << UI::rendererName() << "\n";
+    char line[128];
+    snprintf(line, sizeof(line), "%-8s %10s %10s %10s %10s %10s\n", "metric", "samples", "mean", "p50", "p99", "max");
+    file << line;
+    for (int m = 0; m < METRIC_COUNT; ++m) {
+        Metric metric = static_cast<Metric>(m);
+        uint64_t count = samples(metric);
+        int64_t sum = histograms[m].sum.load(std::memory_order_relaxed);
+        snprintf(line, sizeof(line), "%-8s %10llu %10lld %10lld %10lld %10lld\n", METRIC_NAMES[m],
+                 (unsigned long long)count,
+                 (long long)(count ? sum / (int64_t)count : 0),
+                 (long long)percentile(metric, 0.50),
+                 (long long)percentile(metric, 0.99),
+                 (long long)max(metric));
+        file << line;
+    }
+}
@@ -0,0 +1,78 @@
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../include/RecordLog.h"
+
+static bool writeAll(int fd, const void* bytes, size_t length) {
+    size_t done = 0;
+    while (done < length) {
+        ssize_t n = write(fd, static_cast<const char*>(bytes) + done, length - done);
+        if (n <= 0) return false;
+        done += (size_t)n;
+    }
+    return true;
+}
+
+int RecordLog::openLog(const std::string& path, bool append) {
+    if (append) {
+        // the directory and its parents (~/.config may not exist yet)
+        for (size_t slash = path.find('/', 1); slash != std::string::npos; slash = path.find('/', slash + 1)) {
+            mkdir(path.substr(0, slash).c_str(), 0755);
+        }
+    }
+    int fd = open(path.c_str(), append ? O_RDWR | O_CREAT : O_RDONLY, 0644);
+    if (fd < 0) return -1;
+    if (flock(fd, append ? LOCK_EX : LOCK_SH) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+void RecordLog::closeLog(int fd) {
+    close(fd);
+}
+
+uint64_t RecordLog::logSize(int fd) {
+    struct stat info;
+    return fstat(fd, &info) == 0 ? (uint64_t)info.st_size : 0;
+}
+
+bool RecordLog::readAll(int fd, void* bytes, size_t length) {
+    size_t done = 0;
+    while (done < length) {
+        ssize_t n = read(fd, static_cast<char*>(bytes) + done, length - done);
+        if (n <= 0) return false;
+        done += (size_t)n;
+    }
+    return true;
+}
+
+bool RecordLog::append(int fd, uint64_t end, const void* record, size_t length) {
+    if (logSize(fd) != end && ftruncate(fd, (off_t)end) != 0) return false;
+    return lseek(fd, (off_t)end, SEEK_SET) >= 0 && writeAll(fd, record, length) && fsync(fd) == 0;
+}
+
+bool RecordLog::loadCache(const std::string& path, void* bytes, size_t length) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    bool ok = readAll(fd, bytes, length);
+    close(fd);
+    return ok;
+}
+
+bool RecordLog::saveCache(const std::string& path, const void* bytes, size_t length) {
+    std::string temp = path + ".tmp";
+    int fd = open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+    bool ok = writeAll(fd, bytes, length);
+    ok = close(fd) == 0 && ok;
+    if (!ok || std::rename(temp.c_str(), path.c_str()) != 0) {
+        unlink(temp.c_str());
+        return false;
+    }
+    return true;
+}
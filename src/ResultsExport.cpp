@@ -0,0 +1,66 @@
+#include "../include/ResultsExport.h"
+
+FILE* ResultsExport::file = nullptr;
+ResultsExport::Format ResultsExport::format = ResultsExport::FORMAT_JSONL;
+char ResultsExport::buffer[1 << 20];
+
+ResultsExport::Format ResultsExport::formatForPath(const std::string& path) {
+    size_t dot = path.find_last_of('.');
+    return dot != std::string::npos && path.compare(dot, std::string::npos, ".csv") == 0 ? FORMAT_CSV : FORMAT_JSONL;
+}
+
+bool ResultsExport::open(const std::string& path, Format exportFormat) {
+    if (file) return true;
+    file = path == "-" ? stdout : std::fopen(path.c_str(), "a");
+    if (!file) return false;
+    format = exportFormat;
+    std::setvbuf(file, buffer, _IOFBF, sizeof(buffer));
+    // csv header only for a fresh file, so repeated runs append to one dataset like telemetry
+    std::fseek(file, 0, SEEK_END);
+    if (format == FORMAT_CSV && std::ftell(file) <= 0) {
+        std::fputs("finished,mode,seed,time,completed,place,arr,das,dcd,sdf", file);
+        for (int i = 0; i < GameHistory::COUNTER_COUNT; ++i) std::fprintf(file, ",%s", GameHistory::counterName(i));
+        std::fputs(",splits\n", file);
+    }
+    return true;
+}
+
+void ResultsExport::write(const Result& r) {
+    if (!file) return;
+    // mode names are plain identifiers, nothing in a record needs quoting or escaping
+    if (format == FORMAT_CSV) {
+        std::fprintf(file, "%lld,%s,%u,%.3f,%d,%d,%g,%g,%g,%g", (long long)r.finishedAt, r.mode, r.seed, r.time,
+                     r.completed ? 1 : 0, r.place, r.arr, r.das, r.dcd, r.sdf);
+        for (int i = 0; i < GameHistory::COUNTER_COUNT; ++i) {
+            if (r.untracked & (1u << i)) std::fputc(',', file);
+            else std::fprintf(file, ",%d", r.counters[i]);
+        }
+        std::fputc(',', file);
+        for (int i = 0; i < r.splitCount; ++i) std::fprintf(file, i ? ";%.3f" : "%.3f", r.splits[i]);
+        std::fputc('\n', file);
+        return;
+    }
+    std::fprintf(file, "{\"finished\":%lld,\"mode\":\"%s\",\"seed\":%u,\"time\":%.3f,\"completed\":%s,\"place\":%d,"
+                       "\"handling\":{\"arr\":%g,\"das\":%g,\"dcd\":%g,\"sdf\":%g},\"stats\":{",
+                 (long long)r.finishedAt, r.mode, r.seed, r.time, r.completed ? "true" : "false", r.place,
+                 r.arr, r.das, r.dcd, r.sdf);
+    for (int i = 0; i < GameHistory::COUNTER_COUNT; ++i) {
+        std::fprintf(file, i ? ",\"%s\":" : "\"%s\":", GameHistory::counterName(i));
+        if (r.untracked & (1u << i)) std::fputs("null", file);
+        else std::fprintf(file, "%d", r.counters[i]);
+    }
+    std::fputs("},\"splits\":[", file);
+    for (int i = 0; i < r.splitCount; ++i) std::fprintf(file, i ? ",%.3f" : "%.3f", r.splits[i]);
+    std::fputs("]}\n", file);
+}
+
+void ResultsExport::flush() {
+    if (file) std::fflush(file);
+}
+
+void ResultsExport::close() {
+    if (!file) return;
+    if (file == stdout) std::fflush(file);
+    else std::fclose(file);
+    file = nullptr;
+}
@@ -0,0 +1,97 @@
+#include "../include/RollingStats.h"
+
+#include <algorithm>
+
+void RollingStats::clear() {
+    written = 0;
+    window5 = Window{5.0};
+    window30 = Window{30.0};
+    pieceAttack = 0;
+    pieceGarbage = 0;
+    buckets.fill(0);
+    bucketSeconds = 1.0;
+}
+
+void RollingStats::record(double time, int attack, int garbageCleared) {
+    // the slot about to be reused may still be inside a time window at very high pps,
+    // that window then starts at the overwritten lock instead
+    for (Window* window : {&window5, &window30}) {
+        if (written - window->tail == CAPACITY) {
+            const Lock& lost = at(window->tail);
+            window->floor = lost.time;
+            window->attack -= lost.attack;
+            window->garbage -= lost.garbage;
+            window->tail++;
+        }
+    }
+    ring[written % CAPACITY] = {time, (int16_t)attack, (int16_t)garbageCleared};
+    written++;
+    window5.attack += attack;
+    window5.garbage += garbageCleared;
+    window30.attack += attack;
+    window30.garbage += garbageCleared;
+    pieceAttack += attack;
+    pieceGarbage += garbageCleared;
+    if (written > (uint64_t)PIECE_WINDOW) {
+        const Lock& dropped = at(written - PIECE_WINDOW - 1);
+        pieceAttack -= dropped.attack;
+        pieceGarbage -= dropped.garbage;
+    }
+
+    // halve the resolution until the lock fits, each merge at least doubles the time covered
+    int bucket = (int)(time / bucketSeconds);
+    while (bucket >= TIMELINE_BUCKETS) {
+        for (int i = 0; i < TIMELINE_BUCKETS / 2; ++i) buckets[i] = buckets[2 * i] + buckets[2 * i + 1];
+        std::fill(buckets.begin() + TIMELINE_BUCKETS / 2, buckets.end(), 0);
+        bucketSeconds *= 2.0;
+        bucket = (int)(time / bucketSeconds);
+    }
+    buckets[std::max(0, bucket)]++;
+}
+
+void RollingStats::slide(Window& window, double now) {
+    double start = now - window.seconds;
+    while (window.tail < written && at(window.tail).time <= start) {
+        window.attack -= at(window.tail).attack;
+        window.garbage -= at(window.tail).garbage;
+        window.tail++;
+    }
+}
+
+RollingStats::Rate RollingStats::rate(int pieces, int attack, int garbage, double seconds) {
+    Rate r;
+    if (seconds <= 0.0) return r;
+    r.pps = (float)(pieces / seconds);
+    r.apm = (float)(attack * 60.0 / seconds);
+    r.vs = (float)((attack + garbage) * 100.0 / seconds);
+    return r;
+}
+
+RollingStats::Snapshot RollingStats::rates(double now) {
+    Snapshot snapshot;
+    for (Window* window : {&window5, &window30}) {
+        slide(*window, now);
+        // a young game is measured over its whole length, not over the full window
+        double start = std::max({now - window->seconds, window->floor, 0.0});
+        Rate r = rate((int)(written - window->tail), window->attack, window->garbage, now - start);
+        (window == &window5 ? snapshot.lastSeconds5 : snapshot.lastSeconds30) = r;
+    }
+    // the piece window runs from the lock just before it, or from the start of the game
+    int pieces = (int)std::min<uint64_t>(written, PIECE_WINDOW);
+    double start = written > (uint64_t)PIECE_WINDOW ? at(written - PIECE_WINDOW - 1).time : 0.0;
+    snapshot.lastPieces = rate(pieces, pieceAttack, pieceGarbage, now - start);
+    return snapshot;
+}
+
+std::vector<float> RollingStats::timeline(double now) const {
+    std::vector<float> pps;
+    int used = std::min(TIMELINE_BUCKETS, (int)(now / bucketSeconds) + 1);
+    for (int i = 0; i < used; ++i) {
+        // the last bucket is still filling, only the part already played counts; a sliver of
+        // one would turn a single lock into a spike, so it is left off
+        double seconds = std::min(bucketSeconds, now - i * bucketSeconds);
+        if (i > 0 && seconds < bucketSeconds / 2) break;
+        pps.push_back(seconds > 0.0 ? (float)(buckets[i] / seconds) : 0.0f);
+    }
+    return pps;
+}
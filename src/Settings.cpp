@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <iostream>
 #include <unordered_map>
 #include <vector>
@@ -9,6 +10,7 @@
 #include <sstream>
 #include <sys/stat.h>
 #include <cstdint>
+#include <cstring>
 #include <stdexcept>
 
 #ifdef _WIN32
@@ -25,40 +27,98 @@
     #include <endian.h>
 #endif
 
+#include "../include/ConfigWatcher.h"
+#include "../include/GameHistory.h"
 #include "../include/Settings.h"
 
 // Configuration constants
-static constexpr uint32_t SETTINGS_FORMAT_VERSION = 1;
+static constexpr uint32_t LEGACY_FORMAT_VERSION = 2; // settings.bin, 2 adds hold estimation
+static constexpr uint32_t MIN_FORMAT_VERSION = 1;
 static constexpr uint32_t MAX_KEYBIND_SIZE = 100;
 static_assert(sizeof(uint32_t) == 4, "uint32_t must be 4 bytes");
 
-float Settings::ARR = 10.0f; // auto repeat rate (ms)
-float Settings::DAS = 50.0f; // delayed auto shift (ms)  
-float Settings::DCD = 33.0f; // das cut delay (ms)
-float Settings::SDF = 1.0f; // soft drop factor (ms)
+static const char* STORE_FILE = "settings.store";
+static const char* LEGACY_FILE = "settings.bin";
+
+SettingsStore::Data Settings::store;
 
 std::string Settings::mode = "zen";
+uint32_t Settings::reloadGeneration = 0;
+
+static const char* actionNames[] = {
+    "LEFT", "RIGHT", "ROTATE_CW", "ROTATE_CCW", "FLIP", "HOLD", "SOFT_DROP", "HARD_DROP", "PAUSE", "QUIT", "RESTART"
+};
 
-char Settings::tetrominoCharacter = '.';
-
-std::unordered_map<std::string, std::vector<int>> Settings::keyBindings = {
-    {"LEFT",    {260, 106}},         // left arrow key, j key
-    {"RIGHT",   {261, 108}},         // right arrow key, l key
-    {"ROTATE_CW",  {120}},           // x key
-    {"ROTATE_CCW", {122}},           // z key
-    {"FLIP",     {99}},              // c key
-    {"HOLD",    {259, 105}},         // up arrow, i key
-    {"SOFT_DROP", {258, 107}},       // down arrow, k key
-    {"HARD_DROP", {32}},             // space key
-    {"PAUSE",   {112}},              // p key
-    {"QUIT",    {113, 27}},          // q key, esc
-    {"RESTART", {114, 92}}           // r key, '\'
+// the bindings offered in the settings screen, in display order (pause stays on p)
+static const Settings::Action editableActions[] = {
+    Settings::ACTION_LEFT, Settings::ACTION_RIGHT, Settings::ACTION_ROTATE_CW, Settings::ACTION_ROTATE_CCW,
+    Settings::ACTION_FLIP, Settings::ACTION_HOLD, Settings::ACTION_SOFT_DROP, Settings::ACTION_HARD_DROP,
+    Settings::ACTION_QUIT, Settings::ACTION_RESTART
 };
 
+const char* Settings::actionName(Action action) {
+    return actionNames[action];
+}
+
+static void setKeys(SettingsStore::KeyList& list, std::initializer_list<int> keys) {
+    list.count = 0;
+    for (int key : keys) {
+        if (list.count < (uint32_t)SettingsStore::MAX_KEYS) list.keys[list.count++] = key;
+    }
+}
+
+void Settings::setDefaults() {
+    std::memset(&store, 0, sizeof(store));
+    store.profileCount = 1;
+    store.activeProfile = 0;
+
+    SettingsStore::Profile& p = store.profiles[0];
+    std::snprintf(p.name, sizeof(p.name), "Default");
+    p.arr = 10.0f; // auto repeat rate (ms)
+    p.das = 50.0f; // delayed auto shift (ms)
+    p.dcd = 33.0f; // das cut delay (ms)
+    p.sdf = 1.0f; // soft drop factor (ms)
+
+    setKeys(p.keys[ACTION_LEFT], {260, 106});      // left arrow key, j key
+    setKeys(p.keys[ACTION_RIGHT], {261, 108});     // right arrow key, l key
+    setKeys(p.keys[ACTION_ROTATE_CW], {120});      // x key
+    setKeys(p.keys[ACTION_ROTATE_CCW], {122});     // z key
+    setKeys(p.keys[ACTION_FLIP], {99});            // c key
+    setKeys(p.keys[ACTION_HOLD], {259, 105});      // up arrow, i key
+    setKeys(p.keys[ACTION_SOFT_DROP], {258, 107}); // down arrow, k key
+    setKeys(p.keys[ACTION_HARD_DROP], {32});       // space key
+    setKeys(p.keys[ACTION_PAUSE], {112});          // p key
+    setKeys(p.keys[ACTION_QUIT], {113, 27});       // q key, esc
+    setKeys(p.keys[ACTION_RESTART], {114, 92});    // r key, '\'
+
+    p.holdEstimation = 0;
+    p.repeatDelay = 250.0f; // common desktop default
+    p.repeatInterval = 33.0f; // ~30 repeats per second
+    p.tetrominoCharacter = '.';
+}
+
+static std::string keyListString(const SettingsStore::KeyList& keys) {
+    std::string keyStr;
+    for (uint32_t j = 0; j < keys.count; j++) {
+        if (j > 0) keyStr += ", ";
+        int key = keys.keys[j];
+        if (key == 32) keyStr += "SPACE";
+        else if (key == 27) keyStr += "ESC";
+        else if (key == 260) keyStr += "LEFT";
+        else if (key == 261) keyStr += "RIGHT";
+        else if (key == 258) keyStr += "DOWN";
+        else if (key == 259) keyStr += "UP";
+        else if (key >= 32 && key <= 126) keyStr += (char)key;
+        else keyStr += std::to_string(key);
+    }
+    return keyStr;
+}
+
 void Settings::configure() {
     clear();
     refresh();
     noecho();
+    const GameHistory::Summary& lifetime = GameHistory::totals(); // read once, not on every redraw
     
     int term_rows, term_cols;
     getmaxyx(stdscr, term_rows, term_cols);
@@ -66,14 +126,21 @@ void Settings::configure() {
     std::vector<std::string> settingNames = {
         "LEFT", "RIGHT", "ROTATE_CW", "ROTATE_CCW", "FLIP", 
         "HOLD", "SOFT_DROP", "HARD_DROP", "QUIT", "RESTART",
-        "ARR", "DAS", "DCD", "SDF", "TETROMINO_CHAR"
+        "ARR", "DAS", "DCD", "SDF", "TETROMINO_CHAR",
+        "HOLD_DETECTION", "CALIBRATE_REPEAT", "PROFILE", "ARE", "LINE_CLEAR_DELAY"
+    };
+    std::pair<std::string, uint8_t SettingsStore::Profile::*> delaySettings[] = {
+        {"ARE (Entry Delay)", &SettingsStore::Profile::areFrames},
+        {"Line Clear Delay", &SettingsStore::Profile::lineClearFrames}
     };
+    const int MAX_DELAY_FRAMES = 60;
     
-    std::vector<std::pair<std::string, float*>> handlingSettings = {
-        {"ARR (Auto Repeat Rate)", &ARR},
-        {"DAS (Delayed Auto Shift)", &DAS},
-        {"DCD (DAS Cut Delay)", &DCD},
-        {"SDF (Soft Drop Factor)", &SDF}
+    // member pointers, so switching profiles needs no rebinding
+    std::vector<std::pair<std::string, float SettingsStore::Profile::*>> handlingSettings = {
+        {"ARR (Auto Repeat Rate)", &SettingsStore::Profile::arr},
+        {"DAS (Delayed Auto Shift)", &SettingsStore::Profile::das},
+        {"DCD (DAS Cut Delay)", &SettingsStore::Profile::dcd},
+        {"SDF (Soft Drop Factor)", &SettingsStore::Profile::sdf}
     };
     
     int currentSelection = 0;
@@ -96,37 +163,22 @@ void Settings::configure() {
     int max_value_width = min_value_width;
     // precompute max value width for all keybinds/handling/character
     for (int i = 0; i < 10; i++) {
-        auto it = keyBindings.find(settingNames[i]);
-        std::string keyStr;
-        if (it != keyBindings.end()) {
-            for (size_t j = 0; j < it->second.size(); j++) {
-                if (j > 0) keyStr += ", ";
-                int key = it->second[j];
-                if (key == 32) keyStr += "SPACE";
-                else if (key == 27) keyStr += "ESC";
-                else if (key == 260) keyStr += "LEFT";
-                else if (key == 261) keyStr += "RIGHT";
-                else if (key == 258) keyStr += "DOWN";
-                else if (key == 259) keyStr += "UP";
-                else if (key >= 32 && key <= 126) keyStr += (char)key;
-                else keyStr += std::to_string(key);
-            }
-        }
+        std::string keyStr = keyListString(getKeys(editableActions[i]));
         if ((int)keyStr.size() > max_value_width) max_value_width = keyStr.size();
     }
     for (int i = 0; i < 4; i++) {
-        std::string valueStr = std::to_string(*(handlingSettings[i].second));
+        std::string valueStr = std::to_string(profile().*(handlingSettings[i].second));
         valueStr.erase(valueStr.find_last_not_of('0') + 1, std::string::npos);
         valueStr.erase(valueStr.find_last_not_of('.') + 1, std::string::npos);
         if ((int)valueStr.size() > max_value_width) max_value_width = valueStr.size();
     }
     // tetromino character setting
-    std::string charStr = std::string(1, tetrominoCharacter);
+    std::string charStr = std::string(1, profile().tetrominoCharacter);
     if ((int)charStr.size() > max_value_width) max_value_width = charStr.size();
     // add extra space for input buffer
     max_value_width = std::max(max_value_width, 24);
     int box_width = max_label_width + max_value_width + 16;
-    int box_height = 11 + 10 + 4 + 3; // 10 keybinds, 4 handling, 1 character + headers
+    int box_height = 11 + 10 + 4 + 3 + 4 + 4 + 4; // 10 keybinds, 4 handling, 1 character, 2 input, 2 profile, 2 delays + headers
     int starty = (term_rows - box_height) / 2;
     int startx = (term_cols - box_width) / 2;
 
@@ -188,21 +240,7 @@ void Settings::configure() {
             if (insertMode && currentSelection == i) {
                 value = "Bind to: [" + insertBuffer + "]";
             } else {
-                auto it = keyBindings.find(label);
-                if (it != keyBindings.end()) {
-                    for (size_t j = 0; j < it->second.size(); j++) {
-                        if (j > 0) value += ", ";
-                        int key = it->second[j];
-                        if (key == 32) value += "SPACE";
-                        else if (key == 27) value += "ESC";
-                        else if (key == 260) value += "LEFT";
-                        else if (key == 261) value += "RIGHT";
-                        else if (key == 258) value += "DOWN";
-                        else if (key == 259) value += "UP";
-                        else if (key >= 32 && key <= 126) value += (char)key;
-                        else value += std::to_string(key);
-                    }
-                }
+                value = keyListString(getKeys(editableActions[i]));
             }
             std::string prefix = (currentSelection == i) ? "> " : "  ";
             int label_x = 2 + (int)prefix.size();
@@ -230,7 +268,7 @@ void Settings::configure() {
             if (insertMode && currentSelection == settingIndex) {
                 value = "Enter value: [" + insertBuffer + "]";
             } else {
-                value = std::to_string(*(handlingSettings[i].second));
+                value = std::to_string(profile().*(handlingSettings[i].second));
                 value.erase(value.find_last_not_of('0') + 1, std::string::npos);
                 value.erase(value.find_last_not_of('.') + 1, std::string::npos);
             }
@@ -261,7 +299,7 @@ void Settings::configure() {
         if (insertMode && currentSelection == charSettingIndex) {
             charValue = "Enter char: [" + insertBuffer + "]";
         } else {
-            charValue = std::string(1, tetrominoCharacter);
+            charValue = std::string(1, profile().tetrominoCharacter);
         }
         std::string charPrefix = (currentSelection == charSettingIndex) ? "> " : "  ";
         int char_label_x = 2 + (int)charPrefix.size();
@@ -276,6 +314,87 @@ void Settings::configure() {
         wattroff(settingswin, (currentSelection == charSettingIndex) ? A_BOLD : A_NORMAL);
         mvwprintw(settingswin, row, char_value_x, "%s", shown_char_value.c_str());
         row++;
+        row++;
+
+        // input settings
+        std::string in_header = "=== Input (Legacy Terminals) ===";
+        int in_header_x = (box_width - (int)in_header.size()) / 2;
+        mvwprintw(settingswin, row++, in_header_x, "%s", in_header.c_str());
+        char repeatStr[32];
+        snprintf(repeatStr, sizeof(repeatStr), "%.0f / %.0f ms", profile().repeatDelay, profile().repeatInterval);
+        std::pair<std::string, std::string> inputRows[] = {
+            {"Hold Detection", profile().holdEstimation ? "Estimate" : "Per Frame"},
+            {"Key Repeat (Enter: calibrate)", repeatStr}
+        };
+        for (int i = 0; i < 2; i++) {
+            int settingIndex = 15 + i;
+            std::string prefix = (currentSelection == settingIndex) ? "> " : "  ";
+            int label_x = 2 + (int)prefix.size();
+            int value_x = box_width - 2 - max_value_width;
+            std::string shown_value = inputRows[i].second;
+            shown_value.append(std::max(0, max_value_width - (int)shown_value.size()), ' ');
+            mvwprintw(settingswin, row, 2, "%s", prefix.c_str());
+            wattron(settingswin, (currentSelection == settingIndex) ? A_BOLD : A_NORMAL);
+            mvwprintw(settingswin, row, label_x, "%s", inputRows[i].first.c_str());
+            wattroff(settingswin, (currentSelection == settingIndex) ? A_BOLD : A_NORMAL);
+            mvwprintw(settingswin, row, value_x, "%s", shown_value.c_str());
+            row++;
+        }
+        row++;
+
+        // profiles
+        std::string pr_header = "=== Profile ===";
+        int pr_header_x = (box_width - (int)pr_header.size()) / 2;
+        mvwprintw(settingswin, row++, pr_header_x, "%s", pr_header.c_str());
+        {
+            int settingIndex = 17;
+            char profileStr[48];
+            snprintf(profileStr, sizeof(profileStr), "%s (%u/%u)", profile().name,
+                     store.activeProfile + 1, store.profileCount);
+            std::string label = store.profileCount < (uint32_t)SettingsStore::MAX_PROFILES
+                                    ? "Active (Enter: copy)" : "Active";
+            std::string prefix = (currentSelection == settingIndex) ? "> " : "  ";
+            int label_x = 2 + (int)prefix.size();
+            int value_x = box_width - 2 - max_value_width;
+            std::string shown_value = profileStr;
+            shown_value.append(std::max(0, max_value_width - (int)shown_value.size()), ' ');
+            mvwprintw(settingswin, row, 2, "%s", prefix.c_str());
+            wattron(settingswin, (currentSelection == settingIndex) ? A_BOLD : A_NORMAL);
+            mvwprintw(settingswin, row, label_x, "%s", label.c_str());
+            wattroff(settingswin, (currentSelection == settingIndex) ? A_BOLD : A_NORMAL);
+            mvwprintw(settingswin, row, value_x, "%s", shown_value.c_str());
+            row++;
+        }
+        wattron(settingswin, A_DIM);
+        mvwprintw(settingswin, row++, 4, "Lifetime: %llu games, %lld lines, %.1f h", (unsigned long long)lifetime.games,
+                  (long long)lifetime.counters[GameHistory::COUNTER_LINES], lifetime.seconds / 3600.0);
+        wattroff(settingswin, A_DIM);
+        row++;
+
+        // entry and line-clear delays, in frames like the games that define them
+        std::string dl_header = "=== Delays ===";
+        int dl_header_x = (box_width - (int)dl_header.size()) / 2;
+        mvwprintw(settingswin, row++, dl_header_x, "%s", dl_header.c_str());
+        for (int i = 0; i < 2; i++) {
+            int settingIndex = 18 + i;
+            std::string value;
+            if (insertMode && currentSelection == settingIndex) {
+                value = "Enter frames: [" + insertBuffer + "]";
+            } else {
+                int frames = profile().*(delaySettings[i].second);
+                value = std::to_string(frames) + " f (" + std::to_string(frames * 1000 / 60) + " ms)";
+            }
+            std::string prefix = (currentSelection == settingIndex) ? "> " : "  ";
+            int label_x = 2 + (int)prefix.size();
+            int value_x = box_width - 2 - max_value_width;
+            value.append(std::max(0, max_value_width - (int)value.size()), ' ');
+            mvwprintw(settingswin, row, 2, "%s", prefix.c_str());
+            wattron(settingswin, (currentSelection == settingIndex) ? A_BOLD : A_NORMAL);
+            mvwprintw(settingswin, row, label_x, "%s", delaySettings[i].first.c_str());
+            wattroff(settingswin, (currentSelection == settingIndex) ? A_BOLD : A_NORMAL);
+            mvwprintw(settingswin, row, value_x, "%s", value.c_str());
+            row++;
+        }
         
         wrefresh(settingswin);
         refresh();
@@ -295,34 +414,38 @@ void Settings::configure() {
                     // keybind settings
                     if (!newKeys.empty()) {
                         // check if any of the newKeys are existing keybinds
+                        Action edited = editableActions[currentSelection];
                         bool exists = false;
                         for (int key : newKeys) {
-                            for (auto keybind : keyBindings) {
-                                if (keybind.first == settingNames[currentSelection]) continue;
-                                for (int keycode : keybind.second) {
-                                    if (key == keycode) {
-                                        exists = true;
-                                        break;
-                                    }
-                                }
-                                if (exists) break;
+                            for (int a = 0; a < ACTION_COUNT && !exists; a++) {
+                                if (a != edited && profile().keys[a].contains(key)) exists = true;
                             }
                             if (exists) break;
                         }
-                        if (!exists) keyBindings[settingNames[currentSelection]] = newKeys;
+                        if (!exists) {
+                            SettingsStore::KeyList& keys = profile().keys[edited];
+                            keys.count = 0;
+                            for (int key : newKeys) keys.keys[keys.count++] = key;
+                        }
                     }
                 } else if (currentSelection < 14) {
                     // handling settings
                     if (!insertBuffer.empty()) {
                         float value = std::stof(insertBuffer);
                         if (value >= 0.1f && value <= 99.0f) {
-                            *(handlingSettings[currentSelection - 10].second) = value;
+                            profile().*(handlingSettings[currentSelection - 10].second) = value;
                         }
                     }
+                } else if (currentSelection >= 18) {
+                    // delays
+                    if (!insertBuffer.empty()) {
+                        int frames = std::stoi(insertBuffer);
+                        if (frames <= MAX_DELAY_FRAMES) profile().*(delaySettings[currentSelection - 18].second) = frames;
+                    }
                 } else {
                     // tetromino character setting
                     if (!insertBuffer.empty()) {
-                        tetrominoCharacter = insertBuffer[0];
+                        profile().tetrominoCharacter = insertBuffer[0];
                     }
                 }
                 insertMode = false;
@@ -337,6 +460,7 @@ void Settings::configure() {
                 }
             } else if (currentSelection < 10) {
                 // keybind settings
+                if (newKeys.size() >= (size_t)SettingsStore::MAX_KEYS) continue;
                 newKeys.push_back(ch);
                 if (ch == 32) insertBuffer += "SPACE ";
                 else if (ch == 27) insertBuffer += "ESC ";
@@ -351,6 +475,11 @@ void Settings::configure() {
                 if ((ch >= '0' && ch <= '9') || ch == '.') {
                     insertBuffer += (char)ch;
                 }
+            } else if (currentSelection >= 18) {
+                // delays, whole frames only
+                if (ch >= '0' && ch <= '9' && insertBuffer.size() < 3) {
+                    insertBuffer += (char)ch;
+                }
             } else {
                 // tetromino character setting
                 if (ch >= 32 && ch <= 126) {
@@ -367,13 +496,35 @@ void Settings::configure() {
             } else if (ch == KEY_LEFT && currentSelection >= 10 && currentSelection < 14) {
                 // decrease handling by 5
                 int handlingIndex = currentSelection - 10;
-                float* setting = handlingSettings[handlingIndex].second;
-                *setting = std::max(0.1f, *setting - 5.0f);
+                float& setting = profile().*(handlingSettings[handlingIndex].second);
+                setting = std::max(0.1f, setting - 5.0f);
             } else if (ch == KEY_RIGHT && currentSelection >= 10 && currentSelection < 14) {
                 // increase handling by 5
                 int handlingIndex = currentSelection - 10;
-                float* setting = handlingSettings[handlingIndex].second;
-                *setting = std::min(99.0f, *setting + 5.0f);
+                float& setting = profile().*(handlingSettings[handlingIndex].second);
+                setting = std::min(99.0f, setting + 5.0f);
+            } else if ((ch == KEY_LEFT || ch == KEY_RIGHT) && currentSelection >= 18) {
+                // one frame at a time
+                uint8_t& frames = profile().*(delaySettings[currentSelection - 18].second);
+                if (ch == KEY_LEFT && frames > 0) frames--;
+                else if (ch == KEY_RIGHT && frames < MAX_DELAY_FRAMES) frames++;
+            } else if ((ch == '\n' || ch == KEY_ENTER || ch == KEY_LEFT || ch == KEY_RIGHT) && currentSelection == 15) {
+                profile().holdEstimation = !profile().holdEstimation;
+            } else if ((ch == '\n' || ch == KEY_ENTER) && currentSelection == 16) {
+                calibrateKeyRepeat();
+                clear();
+                refresh();
+            } else if ((ch == KEY_LEFT || ch == KEY_RIGHT) && currentSelection == 17) {
+                int step = ch == KEY_LEFT ? -1 : 1;
+                store.activeProfile = (store.activeProfile + store.profileCount + step) % store.profileCount;
+            } else if ((ch == '\n' || ch == KEY_ENTER) && currentSelection == 17) {
+                // new profiles start as a copy of the active one
+                if (store.profileCount < (uint32_t)SettingsStore::MAX_PROFILES) {
+                    uint32_t added = store.profileCount++;
+                    store.profiles[added] = profile();
+                    std::snprintf(store.profiles[added].name, sizeof(store.profiles[added].name), "Profile %u", added + 1);
+                    store.activeProfile = added;
+                }
             } else if (ch == '\n' || ch == KEY_ENTER) {
                 insertMode = true;
                 insertBuffer.clear();
@@ -395,8 +546,61 @@ void Settings::configure() {
     refresh();
 }
 
-std::unordered_map<std::string, std::vector<int>> Settings::getKeyBindings() {
-    return keyBindings;
+bool Settings::calibrateKeyRepeat() {
+    int width = 44, height = 7;
+    WINDOW* calwin = newwin(height, width, (LINES - height) / 2, (COLS - width) / 2);
+    box(calwin, 0, 0);
+    mvwprintw(calwin, 2, 3, "Hold any key for about 2 seconds...");
+    mvwprintw(calwin, 4, 3, "(q to cancel)");
+    wrefresh(calwin);
+
+    // wait for the first key, then record every autorepeat that follows it
+    flushinp();
+    std::vector<std::chrono::steady_clock::time_point> arrivals;
+    int first = getch();
+    if (first != 'q' && first != 27 && first != ERR) {
+        arrivals.push_back(std::chrono::steady_clock::now());
+        timeout(20);
+        while (arrivals.size() < 60 && std::chrono::steady_clock::now() - arrivals.front() < std::chrono::milliseconds(2500)) {
+            int ch = getch();
+            if (ch == ERR) continue;
+            if (ch != first) break;
+            arrivals.push_back(std::chrono::steady_clock::now());
+        }
+        timeout(-1);
+    }
+    flushinp();
+
+    bool valid = false;
+    if (arrivals.size() >= 4) {
+        auto ms = [](std::chrono::steady_clock::duration d) {
+            return std::chrono::duration<float, std::milli>(d).count();
+        };
+        float delay = ms(arrivals[1] - arrivals[0]);
+        std::vector<float> gaps;
+        for (size_t i = 2; i < arrivals.size(); i++) gaps.push_back(ms(arrivals[i] - arrivals[i - 1]));
+        // median, so a frame hiccup in the middle doesn't skew the interval
+        std::nth_element(gaps.begin(), gaps.begin() + gaps.size() / 2, gaps.end());
+        float interval = gaps[gaps.size() / 2];
+        if (delay >= 50.0f && delay <= 1000.0f && interval >= 5.0f && interval <= 200.0f) {
+            profile().repeatDelay = delay;
+            profile().repeatInterval = interval;
+            valid = true;
+        }
+    }
+
+    werase(calwin);
+    box(calwin, 0, 0);
+    if (valid) {
+        mvwprintw(calwin, 2, 3, "Delay %.0f ms, interval %.0f ms", profile().repeatDelay, profile().repeatInterval);
+    } else {
+        mvwprintw(calwin, 2, 3, "No autorepeat detected, unchanged");
+    }
+    mvwprintw(calwin, 4, 3, "Press any key to continue");
+    wrefresh(calwin);
+    getch();
+    delwin(calwin);
+    return valid;
 }
 
 std::string Settings::getUserDataPath() {
@@ -420,41 +624,46 @@ void Settings::saveConfig() {
 #else
     mkdir(path.c_str(), 0755);
 #endif
-    std::ofstream file(path + "settings.bin", std::ios::binary);
-    if (!file) return;
-
-    // write format version
-    uint32_t version = htole32(SETTINGS_FORMAT_VERSION);
-    file.write(reinterpret_cast<const char*>(&version), sizeof(version));
-
-    file.write(reinterpret_cast<const char*>(&ARR), sizeof(ARR));
-    file.write(reinterpret_cast<const char*>(&DAS), sizeof(DAS));
-    file.write(reinterpret_cast<const char*>(&DCD), sizeof(DCD));
-    file.write(reinterpret_cast<const char*>(&SDF), sizeof(SDF));
-    const char* actions[] = {"LEFT", "RIGHT", "ROTATE_CW", "ROTATE_CCW", "FLIP", "HOLD", "SOFT_DROP", "HARD_DROP", "PAUSE", "QUIT", "RESTART"};
-    for (int i = 0; i < 11; ++i) {
-        const auto& keys = keyBindings[actions[i]];
-        uint32_t size = htole32(static_cast<uint32_t>(keys.size()));
-        file.write(reinterpret_cast<const char*>(&size), sizeof(size));
-        for (int k : keys) {
-            uint32_t key = htole32(static_cast<uint32_t>(k));
-            file.write(reinterpret_cast<const char*>(&key), sizeof(key));
-        }
+    // anything the watcher picked up until now is older than what we are about to write
+    ConfigWatcher::discard();
+    if (!SettingsStore::save(path + STORE_FILE, store)) {
+        std::cerr << "Error saving settings to " << path << STORE_FILE << std::endl;
     }
+}
 
-    file.write(reinterpret_cast<const char*>(&tetrominoCharacter), sizeof(tetrominoCharacter));
+void Settings::watchConfig() {
+    ConfigWatcher::start(getUserDataPath() + STORE_FILE);
+}
 
-    file.close();
+bool Settings::reload() {
+    std::unique_ptr<SettingsStore::Data> fresh = ConfigWatcher::take();
+    if (!fresh) return false;
+    store = *fresh;
+    reloadGeneration++;
+    return true;
 }
 
 void Settings::loadConfig() {
     std::string path = getUserDataPath();
-    std::ifstream file(path + "settings.bin", std::ios::binary);
-    if (!file) {
-        saveConfig();
-        return;
+    if (SettingsStore::load(path + STORE_FILE, store)) return;
+
+    struct stat info;
+    if (stat((path + STORE_FILE).c_str(), &info) == 0) {
+        std::cerr << "Settings store failed validation, using default settings and regenerating it" << std::endl;
+        setDefaults();
+    } else {
+        // first run with the store: carry over settings.bin if there is one
+        setDefaults();
+        if (!loadLegacy(path + LEGACY_FILE)) setDefaults();
     }
+    saveConfig();
+}
 
+bool Settings::loadLegacy(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file) return false;
+
+    SettingsStore::Profile& p = profile();
     try {
         // read and validate format version
         uint32_t version = 0;
@@ -464,72 +673,70 @@ void Settings::loadConfig() {
         }
         version = le32toh(version);
         
-        if (version != SETTINGS_FORMAT_VERSION) {
+        if (version < MIN_FORMAT_VERSION || version > LEGACY_FORMAT_VERSION) {
             throw std::runtime_error("Unsupported format version " + std::to_string(version) + 
-                                   " (expected " + std::to_string(SETTINGS_FORMAT_VERSION) + ")");
+                                   " (expected " + std::to_string(LEGACY_FORMAT_VERSION) + ")");
         }
 
         // read handling settings with validation
-        file.read(reinterpret_cast<char*>(&ARR), sizeof(ARR));
-        if (file.gcount() != sizeof(ARR)) {
-            throw std::runtime_error("Failed to read ARR setting");
-        }
-        
-        file.read(reinterpret_cast<char*>(&DAS), sizeof(DAS));
-        if (file.gcount() != sizeof(DAS)) {
-            throw std::runtime_error("Failed to read DAS setting");
-        }
-        
-        file.read(reinterpret_cast<char*>(&DCD), sizeof(DCD));
-        if (file.gcount() != sizeof(DCD)) {
-            throw std::runtime_error("Failed to read DCD setting");
-        }
-        
-        file.read(reinterpret_cast<char*>(&SDF), sizeof(SDF));
-        if (file.gcount() != sizeof(SDF)) {
-            throw std::runtime_error("Failed to read SDF setting");
+        float* handling[] = {&p.arr, &p.das, &p.dcd, &p.sdf};
+        const char* handlingNames[] = {"ARR", "DAS", "DCD", "SDF"};
+        for (int i = 0; i < 4; ++i) {
+            file.read(reinterpret_cast<char*>(handling[i]), sizeof(float));
+            if (file.gcount() != sizeof(float)) {
+                throw std::runtime_error(std::string("Failed to read ") + handlingNames[i] + " setting");
+            }
         }
 
         // read key bindings with endianness conversion and validation
-        const char* actions[] = {"LEFT", "RIGHT", "ROTATE_CW", "ROTATE_CCW", "FLIP", "HOLD", "SOFT_DROP", "HARD_DROP", "PAUSE", "QUIT", "RESTART"};
-        for (int i = 0; i < 11; ++i) {
+        for (int i = 0; i < ACTION_COUNT; ++i) {
             uint32_t size = 0;
             file.read(reinterpret_cast<char*>(&size), sizeof(size));
             if (file.gcount() != sizeof(size)) {
-                throw std::runtime_error("Failed to read key binding size for " + std::string(actions[i]));
+                throw std::runtime_error("Failed to read key binding size for " + std::string(actionNames[i]));
             }
             size = le32toh(size);
             
             // sanity check to prevent excessive memory allocation
             if (size > MAX_KEYBIND_SIZE) {
-                throw std::runtime_error("Invalid key binding size " + std::to_string(size) + " for " + actions[i]);
+                throw std::runtime_error("Invalid key binding size " + std::to_string(size) + " for " + actionNames[i]);
             }
             
-            std::vector<int> keys(size);
+            // the store keeps at most MAX_KEYS per action, extra keys are dropped
+            SettingsStore::KeyList& keys = p.keys[i];
+            keys.count = 0;
             for (uint32_t j = 0; j < size; ++j) {
                 uint32_t key = 0;
                 file.read(reinterpret_cast<char*>(&key), sizeof(key));
                 if (file.gcount() != sizeof(key)) {
-                    throw std::runtime_error("Failed to read key " + std::to_string(j) + " for " + actions[i]);
+                    throw std::runtime_error("Failed to read key " + std::to_string(j) + " for " + actionNames[i]);
                 }
-                keys[j] = static_cast<int>(le32toh(key));
+                if (keys.count < (uint32_t)SettingsStore::MAX_KEYS) keys.keys[keys.count++] = static_cast<int>(le32toh(key));
             }
-            keyBindings[actions[i]] = keys;
         }
 
         // Read tetromino character
-        file.read(reinterpret_cast<char*>(&tetrominoCharacter), sizeof(tetrominoCharacter));
-        if (file.gcount() != sizeof(tetrominoCharacter)) {
+        file.read(reinterpret_cast<char*>(&p.tetrominoCharacter), sizeof(p.tetrominoCharacter));
+        if (file.gcount() != sizeof(p.tetrominoCharacter)) {
             throw std::runtime_error("Failed to read tetromino character");
         }
 
+        // version 1 files stop here and keep the default input settings
+        if (version >= 2) {
+            uint8_t estimation = 0;
+            file.read(reinterpret_cast<char*>(&estimation), sizeof(estimation));
+            file.read(reinterpret_cast<char*>(&p.repeatDelay), sizeof(p.repeatDelay));
+            file.read(reinterpret_cast<char*>(&p.repeatInterval), sizeof(p.repeatInterval));
+            if (!file) {
+                throw std::runtime_error("Failed to read input settings");
+            }
+            p.holdEstimation = estimation != 0;
+        }
+
     } catch (const std::exception& e) {
-        std::cerr << "Error loading settings: " << e.what() << std::endl;
-        std::cerr << "Using default settings and regenerating config file" << std::endl;
-        file.close();
-        saveConfig();
-        return;
+        std::cerr << "Error migrating settings: " << e.what() << std::endl;
+        std::cerr << "Using default settings" << std::endl;
+        return false;
     }
-
-    file.close();
+    return true;
 }
@@ -0,0 +1,106 @@
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../include/SettingsStore.h"
+
+static_assert(sizeof(float) == 4 && sizeof(double) == 8, "store layout assumes ieee floats");
+static_assert(sizeof(SettingsStore::Header) == 16, "header layout changed");
+static_assert(sizeof(SettingsStore::Data) % 8 == 0, "version 3 lifetime totals followed Data unpadded");
+
+// reflected crc-32 (zlib) table, computed at compile time so concurrent callers share it safely
+struct Crc32Table {
+    uint32_t entries[256];
+
+    constexpr Crc32Table() : entries{} {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            entries[i] = c;
+        }
+    }
+};
+
+static constexpr Crc32Table crcTable{};
+
+uint32_t SettingsStore::crc32(const void* bytes, size_t length) {
+    const unsigned char* p = static_cast<const unsigned char*>(bytes);
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < length; ++i) crc = crcTable.entries[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    return crc ^ 0xFFFFFFFFu;
+}
+
+static uint32_t bodyChecksum(const void* record, size_t size) {
+    const char* body = static_cast<const char*>(record) + sizeof(SettingsStore::Header);
+    return SettingsStore::crc32(body, size - sizeof(SettingsStore::Header));
+}
+
+bool SettingsStore::load(const std::string& path, Data& data) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat info;
+    // version 3 ended in lifetime totals, since kept by the game history; they are dropped
+    size_t size = fstat(fd, &info) == 0 && info.st_size > 0 ? (size_t)info.st_size : 0;
+    if (size != sizeof(Data) && size != sizeof(Data) + V3_LIFETIME_BYTES) {
+        close(fd);
+        return false;
+    }
+    void* map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return false;
+
+    // the layout is in host byte order; a file from a host of the other endianness fails the magic
+    // check and defaults are used
+    const Data* stored = static_cast<const Data*>(map);
+    bool valid = stored->header.magic == MAGIC &&
+                 stored->header.version == (size == sizeof(Data) ? VERSION : 3) &&
+                 stored->header.size == size &&
+                 stored->header.checksum == bodyChecksum(stored, size) &&
+                 stored->profileCount >= 1 && stored->profileCount <= MAX_PROFILES &&
+                 stored->activeProfile < stored->profileCount;
+    if (valid) {
+        for (uint32_t p = 0; p < stored->profileCount && valid; ++p) {
+            for (const KeyList& keys : stored->profiles[p].keys) {
+                if (keys.count > MAX_KEYS) valid = false;
+            }
+        }
+    }
+    if (valid) std::memcpy(&data, stored, sizeof(Data));
+    munmap(map, size);
+    return valid;
+}
+
+bool SettingsStore::save(const std::string& path, Data& data) {
+    data.header.magic = MAGIC;
+    data.header.version = VERSION;
+    data.header.size = sizeof(Data);
+    data.header.checksum = bodyChecksum(&data, sizeof(Data));
+
+    std::string temp = path + ".tmp";
+    int fd = open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+    const char* bytes = reinterpret_cast<const char*>(&data);
+    size_t written = 0;
+    while (written < sizeof(Data)) {
+        ssize_t n = write(fd, bytes + written, sizeof(Data) - written);
+        if (n <= 0) break;
+        written += (size_t)n;
+    }
+    bool ok = written == sizeof(Data) && fsync(fd) == 0;
+    ok = close(fd) == 0 && ok;
+    if (!ok || rename(temp.c_str(), path.c_str()) != 0) {
+        unlink(temp.c_str());
+        return false;
+    }
+
+    // persist the rename itself
+    std::string dir = path.substr(0, path.find_last_of('/') + 1);
+    int dirfd = open(dir.empty() ? "." : dir.c_str(), O_RDONLY);
+    if (dirfd >= 0) {
+        fsync(dirfd);
+        close(dirfd);
+    }
+    return true;
+}
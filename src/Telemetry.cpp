@@ -0,0 +1,61 @@
+#include <chrono>
+
+#include "../include/Telemetry.h"
+
+SpscQueue<Telemetry::PieceRecord, 1024> Telemetry::queue;
+FILE* Telemetry::file = nullptr;
+std::thread Telemetry::writer;
+std::atomic<bool> Telemetry::writing{false};
+std::atomic<uint64_t> Telemetry::droppedCount{0};
+
+bool Telemetry::open(const std::string& path) {
+    if (file) return true;
+    file = std::fopen(path.c_str(), "a");
+    if (!file) return false;
+    // header only for a fresh file so repeated sessions append to one dataset
+    std::fseek(file, 0, SEEK_END);
+    if (std::ftell(file) == 0) {
+        std::fprintf(file, "game,mode,piece,type,x,y,rotation,inputs,input_count,lock_ms,"
+                           "lines,attack,tspin,mini,pc,b2b,combo\n");
+    }
+    writing = true;
+    writer = std::thread(writerLoop);
+    return true;
+}
+
+void Telemetry::record(const PieceRecord& piece) {
+    if (!file) return;
+    if (!queue.push(piece)) {
+        droppedCount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void Telemetry::close() {
+    if (!file) return;
+    writing = false;
+    if (writer.joinable()) writer.join();
+    std::fclose(file);
+    file = nullptr;
+}
+
+void Telemetry::writerLoop() {
+    PieceRecord piece;
+    while (true) {
+        bool stopping = !writing.load();
+        bool wrote = false;
+        while (queue.pop(piece)) {
+            writeRecord(piece);
+            wrote = true;
+        }
+        if (wrote) std::fflush(file);
+        if (stopping) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+}
+
+void Telemetry::writeRecord(const PieceRecord& piece) {
+    std::fprintf(file, "%lld,%s,%d,%c,%d,%d,%d,%s,%d,%u,%d,%d,%d,%d,%d,%d,%d\n",
+                 (long long)piece.game, piece.mode, piece.piece, piece.type,
+                 piece.x, piece.y, piece.rotation, piece.inputs, piece.inputCount, piece.lockMs,
+                 piece.lines, piece.attack, piece.tspin, piece.mini, piece.pc, piece.b2b, piece.combo);
+}
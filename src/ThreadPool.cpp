@@ -0,0 +1,73 @@
+#include <algorithm>
+
+#include "../include/ThreadPool.h"
+
+ThreadPool::ThreadPool(int threads) {
+    if (threads <= 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 0; i < threads - 1; ++i) {
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::parallelFor(int count, const std::function<void(int, int)>& fn) {
+    if (count <= 0) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &fn;
+        jobCount = count;
+        batches = std::min(count, size());
+        nextBatch = 0;
+        finished = 0;
+        ++generation;
+    }
+    wake.notify_all();
+    runBatches();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [&]() { return finished == batches; });
+    job = nullptr;
+}
+
+void ThreadPool::workerLoop() {
+    unsigned seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&]() { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+        }
+        runBatches();
+    }
+}
+
+void ThreadPool::runBatches() {
+    while (true) {
+        const std::function<void(int, int)>* fn;
+        int begin, end;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!job || nextBatch >= batches) return;
+            int batch = nextBatch++;
+            fn = job;
+            begin = (int)((long long)batch * jobCount / batches);
+            end = (int)((long long)(batch + 1) * jobCount / batches);
+        }
+        (*fn)(begin, end);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (++finished == batches) done.notify_all();
+        }
+    }
+}
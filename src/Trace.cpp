@@ -0,0 +1,126 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "../include/Trace.h"
+
+struct Trace::Ring {
+    Event events[RING_CAPACITY];
+    // total events pushed, the ring holds the last RING_CAPACITY; bumped with release once an
+    // event is filled in, so write() can read the ring while its thread still records
+    std::atomic<uint64_t> written{0};
+    int tid = 0;
+    const char* name = "thread";
+    bool released = false; // its thread exited, free for the next one of the same name
+};
+
+std::atomic<bool> Trace::enabled{false};
+std::string Trace::outputPath;
+int64_t Trace::startTime = 0;
+std::mutex Trace::ringsMutex;
+std::vector<std::unique_ptr<Trace::Ring>> Trace::rings;
+thread_local Trace::RingHandle Trace::currentRing;
+
+void Trace::setOutput(const std::string& path) {
+    outputPath = path;
+    startTime = now();
+    enabled = !path.empty();
+}
+
+Trace::RingHandle::~RingHandle() {
+    if (!ring) return;
+    std::lock_guard<std::mutex> lock(ringsMutex);
+    ring->released = true;
+}
+
+Trace::Ring* Trace::acquireRing(const char* name) {
+    std::lock_guard<std::mutex> lock(ringsMutex);
+    // threads restarted over and over (the renderer, on every pause) reuse one ring and one tid
+    for (const auto& ring : rings) {
+        if (ring->released && std::strcmp(ring->name, name) == 0) {
+            ring->released = false;
+            return ring.get();
+        }
+    }
+    rings.emplace_back(new Ring());
+    Ring* ring = rings.back().get();
+    ring->tid = (int)rings.size();
+    ring->name = name;
+    return ring;
+}
+
+Trace::Ring* Trace::threadRing() {
+    if (!currentRing.ring) currentRing.ring = acquireRing("thread");
+    return currentRing.ring;
+}
+
+void Trace::registerThread(const char* name) {
+    if (!isEnabled()) return;
+    if (!currentRing.ring) {
+        currentRing.ring = acquireRing(name);
+    } else {
+        std::lock_guard<std::mutex> lock(ringsMutex);
+        currentRing.ring->name = name;
+    }
+}
+
+void Trace::complete(const char* name, int64_t start, int64_t end) {
+    if (!isEnabled()) return;
+    Ring* ring = threadRing();
+    uint64_t index = ring->written.load(std::memory_order_relaxed);
+    Event& event = ring->events[index % RING_CAPACITY];
+    event.name = name;
+    event.start = start;
+    event.duration = end - start;
+    ring->written.store(index + 1, std::memory_order_release);
+}
+
+void Trace::instant(const char* name) {
+    if (!isEnabled()) return;
+    Ring* ring = threadRing();
+    uint64_t index = ring->written.load(std::memory_order_relaxed);
+    Event& event = ring->events[index % RING_CAPACITY];
+    event.name = name;
+    event.start = now();
+    event.duration = -1;
+    ring->written.store(index + 1, std::memory_order_release);
+}
+
+void Trace::write() {
+    if (!isEnabled()) return;
+    enabled = false; // stop recording before the rings are read
+
+    FILE* file = std::fopen(outputPath.c_str(), "w");
+    if (!file) return;
+
+    std::lock_guard<std::mutex> lock(ringsMutex);
+    std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    std::fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"clitris\"}}");
+    std::vector<Event> events;
+    for (const auto& ring : rings) {
+        std::fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                     ring->tid, ring->name);
+        // at exit the input, config watcher and pool threads may not have stopped, and one that
+        // saw recording still on can push a few more events; copy the ring, then keep only the
+        // events no later push can have overwritten meanwhile, the slot of the next push included
+        uint64_t end = ring->written.load(std::memory_order_acquire);
+        uint64_t first = end > (uint64_t)RING_CAPACITY ? end - RING_CAPACITY : 0;
+        events.clear();
+        for (uint64_t i = first; i < end; ++i) events.push_back(ring->events[i % RING_CAPACITY]);
+        uint64_t after = ring->written.load(std::memory_order_acquire);
+        uint64_t intact = after >= (uint64_t)RING_CAPACITY ? after - RING_CAPACITY + 1 : 0;
+        for (uint64_t i = std::max(first, intact); i < end; ++i) {
+            const Event& event = events[i - first];
+            double ts = (event.start - startTime) / 1000.0;
+            if (event.duration < 0) {
+                std::fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,\"pid\":1,\"tid\":%d}",
+                             event.name, ts, ring->tid);
+            } else {
+                std::fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d}",
+                             event.name, ts, event.duration / 1000.0, ring->tid);
+            }
+        }
+    }
+    std::fprintf(file, "\n]}\n");
+    std::fclose(file);
+}
@@ -1,13 +1,65 @@
 #include <unordered_map>
 #include <curses.h>
+#include <chrono>
 #include <cstring>
+#include <tuple>
+#include <algorithm>
 
 #include "../include/UI.h"
 #include "../include/GameUtils.h"
-#include "../include/Settings.h"
+#include "../include/InputReader.h"
+#include "../include/AnsiRenderer.h"
+#include "../include/Profiler.h"
+#include "../include/Trace.h"
+#include "../include/OutputMonitor.h"
 
-void UI::renderBoard(WINDOW* win, const std::vector<std::vector<int>>& board, int board_height, int board_width, int cell_width) {
-    char tetrominoCharacter = Settings::getTetrominoCharacter();
+bool UI::framePending = false;
+UI::Renderer UI::renderer = UI::RENDER_CURSES;
+
+// colored blocks cost an SGR sequence per color change; congested links get plain reverse video
+static attr_t blockAttributes(int color, attr_t extra) {
+    if (OutputMonitor::level() >= OutputMonitor::MONOCHROME) return A_REVERSE;
+    return COLOR_PAIR(color) | extra;
+}
+
+void UI::stage(WINDOW* win) {
+    if (renderer == RENDER_ANSI) AnsiRenderer::stage(win);
+    else wnoutrefresh(win);
+    framePending = true;
+}
+
+void UI::clearScreen() {
+    clear();
+    refresh();
+    if (renderer == RENDER_ANSI) AnsiRenderer::invalidate();
+}
+
+void UI::flushFrame() {
+    if (!framePending) return;
+    framePending = false;
+    Trace::Span span("doupdate");
+    auto start = std::chrono::steady_clock::now();
+
+    size_t bytes = 0;
+    if (renderer == RENDER_ANSI) {
+        // our own buffer, so the sync markers travel in the same write as the frame
+        bytes = AnsiRenderer::flush(InputReader::synchronizedOutput());
+    } else {
+        // curses flushes its own buffer at the end of doupdate, before an end marker could be
+        // appended; markers would cost two extra writes per frame, so these go out unsynchronized
+        doupdate();
+    }
+
+    int64_t micros = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    OutputMonitor::frameWritten(bytes, micros);
+    if (Profiler::isEnabled()) {
+        Profiler::record(Profiler::OUTPUT, micros);
+        if (renderer == RENDER_ANSI) Profiler::record(Profiler::BYTES, (int64_t)bytes);
+    }
+}
+
+void UI::renderBoard(WINDOW* win, const std::vector<std::vector<int>>& board, char block, int board_height, int board_width, int cell_width) {
     // only render the bottom 20 rows of the 40-row board (rows 20-39)
     int start_row = 20; // skip the top 20 hidden rows
     for (int y = 0; y < board_height; ++y) {
@@ -16,10 +68,10 @@ void UI::renderBoard(WINDOW* win, const std::vector<std::vector<int>>& board, in
             int draw_x = x * cell_width + 1;
             char val = board[board_y][x];
             if (val != 0) {
-                wattron(win, COLOR_PAIR(val) | A_BOLD);
+                wattron(win, blockAttributes(val, A_BOLD));
                 for (int i = 0; i < cell_width; ++i)
-                    mvwaddch(win, y + 1, draw_x + i, tetrominoCharacter);
-                wattroff(win, COLOR_PAIR(val) | A_BOLD);
+                    mvwaddch(win, y + 1, draw_x + i, block);
+                wattroff(win, blockAttributes(val, A_BOLD));
             } else {
                 wattron(win, A_DIM);
                 for (int i = 0; i < cell_width; ++i)
@@ -30,9 +82,8 @@ void UI::renderBoard(WINDOW* win, const std::vector<std::vector<int>>& board, in
     }
 }
 
-void UI::renderTetromino(WINDOW* win, const Tetromino& tetromino, int cell_width, bool ghost) {
-    char tetrominoCharacter = Settings::getTetrominoCharacter();
-    char draw_char = ghost ? '.' : tetrominoCharacter;
+void UI::renderTetromino(WINDOW* win, const Tetromino& tetromino, char block, int cell_width, bool ghost) {
+    char draw_char = ghost ? '.' : block;
     int color = tetromino.getColor();
     int px = tetromino.getX();
     int py = tetromino.getY();
@@ -46,15 +97,15 @@ void UI::renderTetromino(WINDOW* win, const Tetromino& tetromino, int cell_width
                 // Only draw if the piece is in the visible area (rows 20-39 of board)
                 if (by >= 0 && by < 20) {
                     if (ghost) {
-                        wattron(win, COLOR_PAIR(color) | A_BOLD);
+                        wattron(win, blockAttributes(color, A_BOLD));
                         mvwaddch(win, by + 1, draw_x, '.');
                         mvwaddch(win, by + 1, draw_x + 1, '.');
-                        wattroff(win, COLOR_PAIR(color) | A_BOLD);
+                        wattroff(win, blockAttributes(color, A_BOLD));
                     } else {
-                        wattron(win, COLOR_PAIR(color) | A_BOLD);
+                        wattron(win, blockAttributes(color, A_BOLD));
                         mvwaddch(win, by + 1, draw_x, draw_char);
                         mvwaddch(win, by + 1, draw_x + 1, draw_char);
-                        wattroff(win, COLOR_PAIR(color) | A_BOLD);
+                        wattroff(win, blockAttributes(color, A_BOLD));
                     }
                 }
             }
@@ -73,10 +124,10 @@ void UI::renderGhostPiece(WINDOW* win, const Tetromino& tetromino, const std::ve
             break;
         }
     }
-    renderTetromino(win, ghost, cell_width, true);
+    renderTetromino(win, ghost, '.', cell_width, true);
 }
 
-void UI::renderPieceBox(WINDOW* win, const Tetromino& tetromino, int cell_width) {
+void UI::renderPieceBox(WINDOW* win, const Tetromino& tetromino, char block, int cell_width) {
     if (tetromino.getType() != 0) {
         int box_height, box_width;
         getmaxyx(win, box_height, box_width);
@@ -86,18 +137,17 @@ void UI::renderPieceBox(WINDOW* win, const Tetromino& tetromino, int cell_width)
         int offsetY = (box_height - 3) / 2 + 1; // 3 is default shape size
         int offsetX = (box_width - shapeW * cell_width) / 2;
         int color = tetromino.getColor();
-        char tetrominoCharacter = Settings::getTetrominoCharacter();
-        
-        wattron(win, COLOR_PAIR(color));
+
+        wattron(win, blockAttributes(color, A_NORMAL));
         for (int y = 0; y < shapeH; ++y) {
             for (int x = 0; x < shapeW; ++x) {
                 if (shape[y][x]) {
                     for (int i = 0; i < cell_width; ++i)
-                        mvwaddch(win, offsetY + y, offsetX + x * cell_width + i, tetrominoCharacter);
+                        mvwaddch(win, offsetY + y, offsetX + x * cell_width + i, block);
                 }
             }
         }
-        wattroff(win, COLOR_PAIR(color));
+        wattroff(win, blockAttributes(color, A_NORMAL));
     }
 }
 
@@ -131,13 +181,22 @@ void UI::renderStatsWindow(WINDOW* win, const std::unordered_map<std::string, in
     print_stat(row++, "Time:", "%.1f", gameTime);
 }
 
-void UI::renderHandling(WINDOW* win) {
+void UI::renderHandling(WINDOW* win, float arr, float das, float dcd, float sdf) {
     box(win, 0, 0);
     mvwprintw(win, 0, 2, "HANDLING");
-    mvwprintw(win, 1, 1, "ARR: %.2f", Settings::getARR());
-    mvwprintw(win, 2, 1, "DAS: %.2f", Settings::getDAS());
-    mvwprintw(win, 3, 1, "DCD: %.2f", Settings::getDCD());
-    mvwprintw(win, 4, 1, "SDF: %.2f", Settings::getSDF());
+    mvwprintw(win, 1, 1, "ARR: %.2f", arr);
+    mvwprintw(win, 2, 1, "DAS: %.2f", das);
+    mvwprintw(win, 3, 1, "DCD: %.2f", dcd);
+    mvwprintw(win, 4, 1, "SDF: %.2f", sdf);
+}
+
+void UI::renderRatesWindow(WINDOW* win, const RollingStats::Snapshot& rates) {
+    box(win, 0, 0);
+    mvwprintw(win, 0, 2, "RECENT");
+    mvwprintw(win, 1, 1, "%-4s%6s%6s%6s", "", "5s", "30s", "100p");
+    mvwprintw(win, 2, 1, "%-4s%6.2f%6.2f%6.2f", "PPS", rates.lastSeconds5.pps, rates.lastSeconds30.pps, rates.lastPieces.pps);
+    mvwprintw(win, 3, 1, "%-4s%6.1f%6.1f%6.1f", "APM", rates.lastSeconds5.apm, rates.lastSeconds30.apm, rates.lastPieces.apm);
+    mvwprintw(win, 4, 1, "%-4s%6.1f%6.1f%6.1f", "VS", rates.lastSeconds5.vs, rates.lastSeconds30.vs, rates.lastPieces.vs);
 }
 
 std::string UI::formatSeconds(double seconds) {
@@ -149,7 +208,9 @@ std::string UI::formatSeconds(double seconds) {
     return std::string(buf);
 }
 
-void UI::showResultsPage(const std::string& mode, const std::unordered_map<std::string, int>& statistics, double gameTime) {
+void UI::showResultsPage(const std::string& mode, const std::unordered_map<std::string, int>& statistics, double gameTime,
+                         const std::vector<float>& ppsTimeline,
+                         const std::vector<std::pair<std::string, std::string>>& extraLines) {
     clear();
     refresh();
     int term_rows, term_cols;
@@ -182,7 +243,10 @@ void UI::showResultsPage(const std::string& mode, const std::unordered_map<std::
     }
 
     int box_width = 48;
-    int box_height = std::min((int)statLines.size() + 12, term_rows - 2);
+    const int chart_rows = 3;
+    float peak = ppsTimeline.empty() ? 0.0f : *std::max_element(ppsTimeline.begin(), ppsTimeline.end());
+    int chart_height = peak > 0.0f ? chart_rows + 2 : 0; // blank line and caption above the bars
+    int box_height = std::min((int)statLines.size() + (int)extraLines.size() + 12 + chart_height, term_rows - 2);
     int start_y = (term_rows - box_height) / 2;
     int start_x = (term_cols - box_width) / 2;
 
@@ -219,6 +283,26 @@ void UI::showResultsPage(const std::string& mode, const std::unordered_map<std::
         modeStat = "Lines: " + std::to_string(statistics.at("lines"));
         statLines.insert(statLines.begin(), {"Score", std::to_string(statistics.at("score"))});
         statLines.insert(statLines.begin(), {"Time", formatSeconds(gameTime)});
+    } else if (mode == "finesse") {
+        auto stat = [&](const char* key) {
+            auto it = statistics.find(key);
+            return it != statistics.end() ? it->second : 0;
+        };
+        int judged = stat("finessePieces");
+        int faults = stat("finesseFaults");
+        char accuracy[16];
+        snprintf(accuracy, sizeof(accuracy), "%.1f%%", judged > 0 ? 100.0 * (judged - faults) / judged : 100.0);
+        title = "FINESSE RESULTS";
+        modeStat = "Faults: " + std::to_string(faults);
+        statLines.insert(statLines.begin(), {"Extra Inputs", std::to_string(stat("finesseExtra"))});
+        statLines.insert(statLines.begin(), {"Pieces Judged", std::to_string(judged)});
+        statLines.insert(statLines.begin(), {"Finesse Accuracy", std::string(accuracy)});
+        statLines.insert(statLines.begin(), {"Time", formatSeconds(gameTime)});
+    } else if (mode == "marathon" || mode == "master") {
+        title = mode == "master" ? "MASTER RESULTS" : "MARATHON RESULTS";
+        modeStat = "Level: " + std::to_string(GameUtils::levelForLines(statistics.at("lines")));
+        statLines.insert(statLines.begin(), {"Score", std::to_string(statistics.at("score"))});
+        statLines.insert(statLines.begin(), {"Time", formatSeconds(gameTime)});
     } else if (mode.find("cheese_") != std::string::npos) {
         title = "CHEESE RESULTS";
         modeStat = std::string("Time: ") + formatSeconds(gameTime);
@@ -228,6 +312,7 @@ void UI::showResultsPage(const std::string& mode, const std::unordered_map<std::
         title = "GAME OVER";
         modeStat = "Mode: " + mode;
     }
+    statLines.insert(statLines.begin(), extraLines.begin(), extraLines.end());
 
     while (true) {
         // title and mode stat
@@ -246,6 +331,106 @@ void UI::showResultsPage(const std::string& mode, const std::unordered_map<std::
             mvwprintw(win, i + 5, 4, "%s", label.c_str());
             mvwprintw(win, i + 5, box_width - 4 - (int)value.size(), "%s", value.c_str());
         }
+        // pps sparkline, two steps per row ('.' half, '|' full) scaled to the peak
+        if (chart_height > 0) {
+            int chart_y = (int)statLines.size() + 6;
+            mvwprintw(win, chart_y, 4, "PPS over the game (peak %.2f)", peak);
+            int chart_x = (box_width - (int)ppsTimeline.size()) / 2;
+            for (int i = 0; i < (int)ppsTimeline.size(); ++i) {
+                int steps = (int)(ppsTimeline[i] / peak * chart_rows * 2 + 0.5f);
+                for (int r = 0; r < chart_rows; ++r) {
+                    int filled = steps - (chart_rows - 1 - r) * 2;
+                    char cell = filled >= 2 ? '|' : filled == 1 ? '.' : ' ';
+                    mvwaddch(win, chart_y + 1 + r, chart_x + i, cell);
+                }
+            }
+        }
+        // footer
+        wattron(win, A_DIM);
+        std::string instr = "[q] or [ESC] to exit";
+        int instr_x = (box_width - (int)instr.size()) / 2;
+        mvwprintw(win, box_height - 2, instr_x, "%s", instr.c_str());
+        wattroff(win, A_DIM);
+        wrefresh(win);
+        int ch = wgetch(win);
+        if (ch == 'q' || ch == 'Q' || ch == 27) break;
+    }
+    delwin(win);
+    clear();
+    refresh();
+}
+
+void UI::showVersusResults(const std::string& winner,
+                           const std::string& leftName, const std::unordered_map<std::string, int>& leftStatistics,
+                           const std::string& rightName, const std::unordered_map<std::string, int>& rightStatistics,
+                           double gameTime) {
+    clear();
+    refresh();
+    int term_rows, term_cols;
+    getmaxyx(stdscr, term_rows, term_cols);
+
+    static const std::vector<std::pair<std::string, std::string>> statLabels = {
+        {"totalPieces", "Total Pieces"},
+        {"attack", "Lines Sent"},
+        {"lines", "Lines Cleared"},
+        {"tetris", "Tetrises"},
+        {"tspins", "T-Spins"},
+        {"pc", "Perfect Clears"},
+        {"max_b2bStreak", "Max B2B Streak"},
+        {"max_combo", "Max Combo"},
+    };
+
+    auto rate = [&](const std::unordered_map<std::string, int>& statistics, const char* key, double scale) {
+        char buf[16];
+        double value = (gameTime > 0) ? (statistics.at(key) * scale / gameTime) : 0.0;
+        snprintf(buf, sizeof(buf), "%.2f", value);
+        return std::string(buf);
+    };
+
+    // label, left value, right value
+    std::vector<std::tuple<std::string, std::string, std::string>> statLines;
+    statLines.emplace_back("Time", formatSeconds(gameTime), formatSeconds(gameTime));
+    statLines.emplace_back("PPS", rate(leftStatistics, "totalPieces", 1.0), rate(rightStatistics, "totalPieces", 1.0));
+    statLines.emplace_back("APM", rate(leftStatistics, "attack", 60.0), rate(rightStatistics, "attack", 60.0));
+    for (const auto& [key, label] : statLabels) {
+        auto l = leftStatistics.find(key);
+        auto r = rightStatistics.find(key);
+        if (l != leftStatistics.end() && r != rightStatistics.end()) {
+            statLines.emplace_back(label, std::to_string(l->second), std::to_string(r->second));
+        }
+    }
+
+    int box_width = 48;
+    int box_height = std::min((int)statLines.size() + 10, term_rows - 2);
+    int start_y = (term_rows - box_height) / 2;
+    int start_x = (term_cols - box_width) / 2;
+
+    WINDOW* win = newwin(box_height, box_width, start_y, start_x);
+    keypad(win, TRUE);
+    box(win, 0, 0);
+
+    std::string title = "VERSUS RESULTS";
+    int left_x = box_width - 16;
+    int right_x = box_width - 4;
+
+    while (true) {
+        wattron(win, A_BOLD);
+        mvwprintw(win, 1, (box_width - (int)title.size()) / 2, "%s", title.c_str());
+        wattroff(win, A_BOLD);
+        mvwprintw(win, 3, (box_width - (int)winner.size()) / 2, "%s", winner.c_str());
+
+        // column headers
+        wattron(win, A_DIM);
+        mvwprintw(win, 5, left_x - (int)leftName.size(), "%s", leftName.c_str());
+        mvwprintw(win, 5, right_x - (int)rightName.size(), "%s", rightName.c_str());
+        wattroff(win, A_DIM);
+
+        for (int i = 0; i < static_cast<int>(statLines.size()); ++i) {
+            const auto& [label, leftValue, rightValue] = statLines[i];
+            mvwprintw(win, i + 6, 4, "%s", label.c_str());
+            mvwprintw(win, i + 6, left_x - (int)leftValue.size(), "%s", leftValue.c_str());
+            mvwprintw(win, i + 6, right_x - (int)rightValue.size(), "%s", rightValue.c_str());
+        }
         // footer
         wattron(win, A_DIM);
         std::string instr = "[q] or [ESC] to exit";
@@ -276,11 +461,36 @@ void UI::showPauseScreen() {
     mvwprintw(pausewin, 1, paused_x, "%s", paused.c_str());
     wattroff(pausewin, A_BOLD);
     std::string instr1 = "[p] to unpause";
-    std::string instr2 = "[q] to quit";
+    std::string instr2 = "[q] to end game";
     int instr1_x = (pause_win_width - instr1.size()) / 2;
     int instr2_x = (pause_win_width - instr2.size()) / 2;
     mvwprintw(pausewin, 2, instr1_x, "%s", instr1.c_str());
     mvwprintw(pausewin, 3, instr2_x, "%s", instr2.c_str());
     wrefresh(pausewin);
     delwin(pausewin);
-}
\ No newline at end of file
+}
+
+bool UI::askYesNo(const std::string& question) {
+    int term_rows, term_cols;
+    getmaxyx(stdscr, term_rows, term_cols);
+    int win_width = std::max(24, (int)question.size() + 6);
+    int win_height = 5;
+    WINDOW* askwin = newwin(win_height, win_width, (term_rows - win_height) / 2, (term_cols - win_width) / 2);
+    keypad(askwin, TRUE);
+    box(askwin, 0, 0);
+    wattron(askwin, A_BOLD);
+    mvwprintw(askwin, 1, (win_width - (int)question.size()) / 2, "%s", question.c_str());
+    wattroff(askwin, A_BOLD);
+    std::string instr = "[y] yes  [n] no";
+    mvwprintw(askwin, 3, (win_width - (int)instr.size()) / 2, "%s", instr.c_str());
+    wrefresh(askwin);
+    bool answer = false;
+    while (true) {
+        int ch = wgetch(askwin);
+        if (ch == 'y' || ch == 'Y' || ch == '\n' || ch == KEY_ENTER) { answer = true; break; }
+        if (ch == 'n' || ch == 'N' || ch == 'q' || ch == 27 || ch == ERR) break;
+    }
+    delwin(askwin);
+    clearScreen();
+    return answer;
+}
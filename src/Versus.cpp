@@ -0,0 +1,100 @@
+#include <curses.h>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+
+#include "../include/Versus.h"
+#include "../include/UI.h"
+#include "../include/Profiler.h"
+#include "../include/Trace.h"
+
+void Versus::layout() {
+    if (layoutCols >= 0) return; // only recomputed at match start and on KEY_RESIZE
+    int term_cols = getmaxx(stdscr);
+    layoutCols = term_cols;
+    players[0].setViewport(0, term_cols / 2);
+    players[1].setViewport(term_cols / 2, term_cols - term_cols / 2);
+    UI::clearScreen();
+}
+
+void Versus::run(const Settings& settings, const Config& config) {
+    nodelay(stdscr, TRUE);
+
+    Game& left = players[0];
+    Game& right = players[1];
+    std::string leftName = config.humanPlayer ? "You" : "Bot 1";
+    std::string rightName = config.humanPlayer ? "Bot" : "Bot 2";
+    left.setLabel(leftName);
+    right.setLabel(rightName);
+    left.setBotControlled(!config.humanPlayer, config.playerPps);
+    right.setBotControlled(true, config.opponentPps);
+
+    auto startMatch = [&]() {
+        left.init();
+        right.init();
+        left.start(settings);
+        right.start(settings);
+        layoutCols = -1;
+    };
+    startMatch();
+
+    InputReader::start();
+    std::vector<InputEvent> input;
+    const std::vector<InputEvent> noInput;
+    int64_t lastFrameStart = 0;
+    while (left.running() && right.running()) {
+        input.clear();
+        {
+            Trace::Span span("poll input");
+            InputReader::drain(input);
+        }
+        InputReader::applyTerminalChanges(); // versus draws on this thread
+
+        // every engine steps on its own clock, keys only reach the left side
+        left.step(settings, input);
+        right.step(settings, noInput);
+        for (const auto& event : input) {
+            if (event.type != InputEvent::PRESS) continue;
+            if (Profiler::isEnabled()) Profiler::inputApplied(event.time);
+            if (event.key == KEY_F(3)) right.invalidate(); // the overlay may have covered either side
+            if (event.key == KEY_RESIZE) layoutCols = -1;
+        }
+
+        right.receiveGarbage(left.takeOutgoingAttack());
+        left.receiveGarbage(right.takeOutgoingAttack());
+
+        if (left.restartRequested()) {
+            startMatch();
+            continue;
+        }
+        if (left.paused()) {
+            double pausedSeconds = left.waitWhilePaused(settings);
+            right.addPausedTime(pausedSeconds);
+            right.invalidate();
+            continue;
+        }
+
+        layout();
+        left.render();
+        right.render();
+        UI::flushFrame();
+        if (Profiler::isEnabled()) {
+            int64_t frameStart = Profiler::now();
+            if (lastFrameStart) Profiler::record(Profiler::FRAME, frameStart - lastFrameStart);
+            lastFrameStart = frameStart;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(16)); // ~60 FPS
+    }
+    InputReader::stop();
+
+    if (!left.quit()) {
+        std::string winner;
+        if (!left.running() && !right.running()) winner = "Draw";
+        else if (!left.running()) winner = rightName + " wins";
+        else winner = leftName + " wins";
+        double gameTime = std::max(left.getGameTime(), right.getGameTime());
+        UI::showVersusResults(winner, leftName, left.getStatistics(), rightName, right.getStatistics(), gameTime);
+    }
+    left.reset();
+    right.reset();
+}
@@ -2,28 +2,180 @@
 #include <csignal>
 #include <curses.h>
 #include <iostream>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
 #include "../include/Game.h"
 #include "../include/Menu.h"
 #include "../include/Settings.h"
+#include "../include/Versus.h"
+#include "../include/BattleRoyale.h"
+#include "../include/ConfigWatcher.h"
+#include "../include/Profiler.h"
+#include "../include/Trace.h"
+#include "../include/Telemetry.h"
+#include "../include/Finesse.h"
+#include "../include/InputReader.h"
+#include "../include/UI.h"
+#include "../include/OutputMonitor.h"
+#include "../include/Leaderboard.h"
+#include "../include/GameHistory.h"
+#include "../include/ResultsExport.h"
 
 void handle_signal(int sig) {
-    (void)sig;
+    // a hangup or kill mid-game is turned into a suspend, the game loop exits after saving
+    if (sig != SIGINT && Game::requestSuspend()) return;
+    InputReader::restoreTerminal();
     endwin();
     std::_Exit(1);
 }
 
-int main() {
+void stop_headless(int) {
+    // finish the current round and return from main, so the exit handlers write every output
+    BattleRoyale::requestStop();
+}
+
+static void printUsage() {
+    std::cerr << "usage: clitris [royale [--players N] [--targeting random|attackers] [--threads N]\n"
+              << "                       [--headless] [--seconds S]]\n"
+              << "               [stats [--mode MODE] [--recent N] [--rebuild]]\n"
+              << "               [--profile] [--profile-out FILE] [--trace FILE]\n"
+              << "               [--telemetry FILE] [--legacy-keys] [--renderer curses|ansi]\n"
+              << "               [--no-adaptive] [--tick-rate HZ]\n"
+              << "               [--results-out FILE|-] [--results-format json|csv]" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    bool royale = false;
+    bool stats = false;
+    bool headless = false;
+    double royaleSeconds = 10.0;
+    BattleRoyale::Config royaleConfig;
+    int statsRecent = 0;
+    bool statsRebuild = false;
+    std::string statsMode;
+    std::string resultsPath;
+    std::string resultsFormat;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "royale") {
+            royale = true;
+        } else if (arg == "stats") {
+            stats = true;
+        } else if (arg == "--mode" && hasValue) {
+            statsMode = argv[++i];
+        } else if (arg == "--recent" && hasValue) {
+            statsRecent = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--rebuild") {
+            statsRebuild = true;
+        } else if (arg == "--results-out" && hasValue) {
+            resultsPath = argv[++i];
+        } else if (arg == "--results-format" && hasValue) {
+            resultsFormat = argv[++i];
+            if (resultsFormat != "json" && resultsFormat != "csv") {
+                printUsage();
+                return 1;
+            }
+        } else if (arg == "--players" && hasValue) {
+            royaleConfig.players = std::max(2, std::min(99, std::atoi(argv[++i])));
+        } else if (arg == "--targeting" && hasValue) {
+            royaleConfig.targeting = BattleRoyale::parseTargeting(argv[++i]);
+        } else if (arg == "--threads" && hasValue) {
+            royaleConfig.threads = std::atoi(argv[++i]);
+        } else if (arg == "--seconds" && hasValue) {
+            royaleSeconds = std::atof(argv[++i]);
+        } else if (arg == "--headless") {
+            headless = true;
+        } else if (arg == "--profile") {
+            Profiler::setEnabled(true);
+            Profiler::toggleOverlay();
+        } else if (arg == "--profile-out" && hasValue) {
+            Profiler::setEnabled(true);
+            Profiler::setReportPath(argv[++i]);
+        } else if (arg == "--trace" && hasValue) {
+            Trace::setOutput(argv[++i]);
+        } else if (arg == "--legacy-keys") {
+            InputReader::setKeyboardProtocol(false);
+        } else if (arg == "--no-adaptive") {
+            OutputMonitor::setEnabled(false);
+        } else if (arg == "--tick-rate" && hasValue) {
+            Game::setTickRate(std::atoi(argv[++i]));
+        } else if (arg == "--renderer" && hasValue) {
+            std::string name = argv[++i];
+            if (name == "ansi") {
+                UI::setRenderer(UI::RENDER_ANSI);
+            } else if (name != "curses") {
+                printUsage();
+                return 1;
+            }
+        } else if (arg == "--telemetry" && hasValue) {
+            if (!Telemetry::open(argv[i + 1])) {
+                std::cerr << "clitris: cannot open telemetry file " << argv[i + 1] << std::endl;
+                return 1;
+            }
+            ++i;
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    // batch-only options; anything but a headless run draws on stdout with curses
+    if (headless && !royale) {
+        std::cerr << "clitris: --headless only applies to royale" << std::endl;
+        return 1;
+    }
+    if (resultsPath == "-" && !(royale && headless)) {
+        std::cerr << "clitris: --results-out - needs royale --headless, stdout is the game screen" << std::endl;
+        return 1;
+    }
+
+    // queries the game history and exits, no terminal setup
+    if (stats) return GameHistory::report(statsRecent, statsMode, statsRebuild);
+
+    if (!resultsPath.empty()) {
+        ResultsExport::Format format = resultsFormat.empty() ? ResultsExport::formatForPath(resultsPath)
+            : resultsFormat == "csv" ? ResultsExport::FORMAT_CSV : ResultsExport::FORMAT_JSONL;
+        if (!ResultsExport::open(resultsPath, format)) {
+            std::cerr << "clitris: cannot open results file " << resultsPath << std::endl;
+            return 1;
+        }
+        atexit(ResultsExport::close);
+    }
+
+    Finesse::init();
+    atexit(Profiler::writeReport);
+    atexit(Trace::write);
+    atexit(Telemetry::close);
+    Trace::registerThread("main");
+
+    if (royale && headless) {
+        std::signal(SIGINT, stop_headless);
+        std::signal(SIGTERM, stop_headless);
+        BattleRoyale battle(royaleConfig);
+        battle.runHeadless(royaleSeconds);
+        return 0;
+    }
+
     setlocale(LC_ALL, "");
     initscr();
 
     atexit([](){ endwin(); });
     std::signal(SIGINT, handle_signal);
     std::signal(SIGTERM, handle_signal);
+    std::signal(SIGHUP, handle_signal);
 
     cbreak();
     noecho();
     keypad(stdscr, TRUE);
     curs_set(0);
+    // ncurses flushes after every cursor move until the screen has been suspended once,
+    // one endwin/refresh cycle lets doupdate send each frame as a single write
+    endwin();
+    refresh();
     if (has_colors()) {
         start_color();
         // 1=White, 2=Green, 3=Yellow, 4=Blue, 5=Magenta, 6=Cyan, 7=Red, 8=Cheese
@@ -40,9 +192,34 @@ int main() {
     Settings settings;
     Menu menu;
     Game game;
+    Versus versus;
 
     bool running = true;
     settings.loadConfig();
+    settings.watchConfig();
+    Leaderboard::load();
+    atexit(ConfigWatcher::stop);
+
+    if (!royale && game.resume(Game::suspendPath())) {
+        std::string mode = Settings::getMode();
+        for (auto& c : mode) {
+            if (c == '_') c = ' ';
+        }
+        bool accepted = UI::askYesNo("Resume suspended " + mode + " game?");
+        std::remove(Game::suspendPath().c_str());
+        if (accepted) {
+            game.run(settings);
+        } else {
+            game.endSuspended();
+        }
+    }
+
+    if (royale) {
+        BattleRoyale battle(royaleConfig);
+        battle.spectate(settings);
+        endwin();
+        return 0;
+    }
 
     while (running) {
         clear();
@@ -153,7 +330,76 @@ int main() {
                         getch();
                 }
                 break;
-            case 5: // keybinds and handling
+            case 5: // versus mode
+                menu.display(4); // versus mode sub-menu
+                choice = menu.getChoice();
+
+                clear();
+                refresh();
+
+                switch(choice) {
+                    case 1: // easy bot
+                        settings.setMode("versus");
+                        versus.run(settings, {true, 0.0f, 1.0f});
+                        break;
+                    case 2: // hard bot
+                        settings.setMode("versus");
+                        versus.run(settings, {true, 0.0f, 2.5f});
+                        break;
+                    case 3: // bot vs bot
+                        settings.setMode("versus");
+                        versus.run(settings, {false, 2.0f, 2.0f});
+                        break;
+                    case 4: { // battle royale spectator
+                        BattleRoyale battle(royaleConfig);
+                        battle.spectate(settings);
+                        break;
+                    }
+                    case -1: // back to main menu
+                        continue;
+                    default:
+                        mvprintw(0, 0, "Invalid choice of %d. Please try again.\n", choice);
+                        refresh();
+                        getch();
+                }
+                break;
+            case 6: // finesse trainer
+                settings.setMode("finesse");
+                game.init();
+                game.run(settings);
+                break;
+            case 7: // practice with undo/redo
+                settings.setMode("practice");
+                game.init();
+                game.run(settings);
+                break;
+            case 8: // marathon and master, with a level speed curve
+                menu.display(5); // marathon mode sub-menu
+                choice = menu.getChoice();
+
+                clear();
+                refresh();
+
+                switch(choice) {
+                    case 1: // 150L, guideline gravity
+                        settings.setMode("marathon");
+                        game.init();
+                        game.run(settings);
+                        break;
+                    case 2: // 20G, shortening lock delay
+                        settings.setMode("master");
+                        game.init();
+                        game.run(settings);
+                        break;
+                    case -1: // back to main menu
+                        continue;
+                    default:
+                        mvprintw(0, 0, "Invalid choice of %d. Please try again.\n", choice);
+                        refresh();
+                        getch();
+                }
+                break;
+            case 9: // keybinds and handling
                 settings.configure();
                 break;
             case -1: // exit